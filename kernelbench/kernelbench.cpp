@@ -0,0 +1,1108 @@
+#include "pch.h"
+
+#include <iomanip>
+#include <numeric>
+#include <random>
+
+#include "WADFile.h"
+#include "FrameBuffer32.h"
+#include "ColumnFrameBuffer32.h"
+#include "Frame.h"
+#include "Projection.h"
+#include "TexturePainter.h"
+#include "MathCache.h"
+#include "SpanDrawer.h"
+
+using namespace rtdoom;
+using std::cout, std::endl, std::string;
+
+namespace
+{
+struct Options
+{
+    string wadFileName;
+    string filter;
+    string wallTexture   = "STARTAN3";
+    string flatTexture   = "FLOOR4_8";
+    string spriteTexture = "POSSA1";
+    int    width         = 640;
+    int    height        = 400;
+    double sampleSeconds = 0.1;
+};
+
+constexpr int s_numSamples = 5;
+
+// amount of work done by a single invocation of a benchmark body
+struct Work
+{
+    size_t calls;
+    size_t pixels;
+};
+
+// accumulates time only around the measured part of a benchmark body
+class Timer
+{
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::duration   m_elapsed {};
+
+public:
+    void Start()
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+    void Stop()
+    {
+        m_elapsed += std::chrono::steady_clock::now() - m_start;
+    }
+    double Seconds() const
+    {
+        return std::chrono::duration<double>(m_elapsed).count();
+    }
+};
+
+// exposes the span merging used when painting planes
+class SpanMerger : public TexturePainter
+{
+public:
+    using TexturePainter::MergeSpans;
+};
+
+// keeps results of pure functions alive
+volatile float s_floatSink;
+volatile int   s_intSink;
+
+// runs the body until the sample time elapses, reports the best of several samples
+template <typename Body>
+void Measure(const Options& options, const string& name, Body body)
+{
+    if(!options.filter.empty() && name.find(options.filter) == string::npos)
+    {
+        return;
+    }
+
+    auto bestCall  = std::numeric_limits<double>::infinity();
+    auto bestPixel = std::numeric_limits<double>::infinity();
+    for(int sample = 0; sample < s_numSamples; sample++)
+    {
+        Timer timer;
+        Work  total {0, 0};
+        while(timer.Seconds() < options.sampleSeconds)
+        {
+            const auto work = body(timer);
+            total.calls += work.calls;
+            total.pixels += work.pixels;
+        }
+        bestCall = std::min(bestCall, timer.Seconds() * 1e9 / total.calls);
+        if(total.pixels)
+        {
+            bestPixel = std::min(bestPixel, timer.Seconds() * 1e9 / total.pixels);
+        }
+    }
+
+    cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12) << bestCall;
+    if(isfinite(bestPixel))
+    {
+        cout << std::setprecision(3) << std::setw(12) << bestPixel;
+    }
+    else
+    {
+        cout << std::setw(12) << "-";
+    }
+    cout << std::defaultfloat << endl;
+}
+
+void PrintUsage()
+{
+    cout << "Usage: kernelbench [options] [file.wad]" << endl
+         << "  --filter TEXT     only run kernels whose name contains TEXT" << endl
+         << "  --res WxH         framebuffer resolution (default: 640x400)" << endl
+         << "  --time SECONDS    length of each of " << s_numSamples << " samples (default: 0.1)" << endl
+         << "  --wall NAME       wall texture used by PaintWall (default: STARTAN3)" << endl
+         << "  --flat NAME       flat used by PaintPlane (default: FLOOR4_8)" << endl
+         << "  --sprite NAME     sprite used by PaintSprite (default: POSSA1)" << endl
+         << "Without a WAD file only the synthetic kernels are measured." << endl;
+}
+
+Options ParseOptions(int argc, char** argv)
+{
+    Options options;
+    for(int i = 1; i < argc; i++)
+    {
+        const string arg(argv[i]);
+        if(arg.size() < 2 || arg.substr(0, 2) != "--")
+        {
+            options.wadFileName = arg;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        const string value(argv[++i]);
+        if(arg == "--filter")
+        {
+            options.filter = value;
+        }
+        else if(arg == "--time")
+        {
+            options.sampleSeconds = std::max(0.001, std::stod(value));
+        }
+        else if(arg == "--wall")
+        {
+            options.wallTexture = value;
+        }
+        else if(arg == "--flat")
+        {
+            options.flatTexture = value;
+        }
+        else if(arg == "--sprite")
+        {
+            options.spriteTexture = value;
+        }
+        else if(arg == "--res")
+        {
+            const auto separator = value.find('x');
+            if(separator == string::npos)
+            {
+                throw std::runtime_error("Invalid resolution " + value);
+            }
+            options.width  = std::stoi(value.substr(0, separator));
+            options.height = std::stoi(value.substr(separator + 1));
+            if(options.width <= 0 || options.height <= 0)
+            {
+                throw std::runtime_error("Invalid resolution " + value);
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+// picks the requested texture or falls back to the first one available
+template <typename T>
+std::optional<string> FindTexture(const std::map<string, T>& textures, const string& name)
+{
+    if(textures.find(name) != textures.end())
+    {
+        return name;
+    }
+    if(textures.empty())
+    {
+        return std::nullopt;
+    }
+    return textures.begin()->first;
+}
+
+Palette SyntheticPalette()
+{
+    Palette palette;
+    for(int i = 0; i < 256; i++)
+    {
+        palette.colors[i].r = static_cast<uint8_t>(i);
+        palette.colors[i].g = static_cast<uint8_t>(255 - i);
+        palette.colors[i].b = static_cast<uint8_t>(i * 7);
+    }
+    return palette;
+}
+
+std::vector<int> RandomTexels(std::mt19937& random, int count)
+{
+    std::uniform_int_distribution<int> texel(0, 246);
+    std::vector<int>                   texels(count);
+    for(auto& t : texels)
+    {
+        t = texel(random);
+    }
+    return texels;
+}
+
+void BenchmarkFrameBuffer(const Options& options, FrameBuffer32& frameBuffer, std::mt19937& random)
+{
+    const auto width  = frameBuffer.m_width;
+    const auto height = frameBuffer.m_height;
+
+    Measure(options, "FrameBuffer32::VerticalLine (color)", [&](Timer& timer) {
+        timer.Start();
+        for(int x = 0; x < width; x++)
+        {
+            frameBuffer.VerticalLine(x, 0, height - 1, x % 6, 0.7f);
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(width), static_cast<size_t>(width) * height};
+    });
+
+    const auto columnTexels = RandomTexels(random, height);
+    Measure(options, "FrameBuffer32::VerticalLine (texels)", [&](Timer& timer) {
+        timer.Start();
+        for(int x = 0; x < width; x++)
+        {
+            frameBuffer.VerticalLine(x, 0, columnTexels, 0.7f);
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(width), static_cast<size_t>(width) * height};
+    });
+
+    // the same columns four at a time, written row by row
+    const std::array<TexelColumn, 4> columns {
+        TexelColumn {0, &columnTexels, 0.7f}, {0, &columnTexels, 0.7f}, {0, &columnTexels, 0.7f}, {0, &columnTexels, 0.7f}};
+    Measure(options, "FrameBuffer32::VerticalLines (4 columns)", [&](Timer& timer) {
+        timer.Start();
+        for(int x = 0; x + 4 <= width; x += 4)
+        {
+            frameBuffer.VerticalLines(x, 4, columns.data());
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(width / 4), static_cast<size_t>(width / 4) * 4 * height};
+    });
+
+    Measure(options, "FrameBuffer32::HorizontalLine (color)", [&](Timer& timer) {
+        timer.Start();
+        for(int y = 0; y < height; y++)
+        {
+            frameBuffer.HorizontalLine(0, width - 1, y, y % 6, 0.7f);
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(height), static_cast<size_t>(width) * height};
+    });
+
+    const auto rowTexels = RandomTexels(random, width);
+    Measure(options, "FrameBuffer32::HorizontalLine (texels)", [&](Timer& timer) {
+        timer.Start();
+        for(int y = 0; y < height; y++)
+        {
+            frameBuffer.HorizontalLine(0, y, rowTexels, 0.7f);
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(height), static_cast<size_t>(width) * height};
+    });
+}
+
+// column-major drawing and the transpose that turns it into mirrored rows
+void BenchmarkColumnFrameBuffer(const Options& options, const Palette& palette, const ColorMap* colorMap, std::mt19937& random)
+{
+    const auto width  = options.width;
+    const auto height = options.height;
+
+    ColumnFrameBuffer32   frameBuffer {width, height, palette, colorMap};
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    frameBuffer.Attach(pixels.data(), []() {});
+
+    const auto columnTexels = RandomTexels(random, height);
+    Measure(options, "ColumnFrameBuffer32::VerticalLine (texels)", [&](Timer& timer) {
+        timer.Start();
+        for(int x = 0; x < width; x++)
+        {
+            frameBuffer.VerticalLine(x, 0, columnTexels, 0.7f);
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(width), static_cast<size_t>(width) * height};
+    });
+
+    Measure(options, "ColumnFrameBuffer32::Flush", [&](Timer& timer) {
+        timer.Start();
+        frameBuffer.Flush();
+        timer.Stop();
+        return Work {1, static_cast<size_t>(width) * height};
+    });
+}
+
+void BenchmarkSpanDrawer(const Options& options, std::mt19937& random)
+{
+    const auto width  = options.width;
+    const auto height = options.height;
+
+    // random 64x64 flat and lit palette, spans at a slant so that both coordinates wrap
+    std::vector<unsigned char>         flat(64 * 64 + Texture::s_padding);
+    std::vector<uint32_t>              colors(256);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for(auto& t : flat)
+    {
+        t = static_cast<unsigned char>(byte(random));
+    }
+    for(auto& c : colors)
+    {
+        c = static_cast<uint32_t>(byte(random)) << 16 | static_cast<uint32_t>(byte(random)) << 8 | byte(random);
+    }
+
+    std::vector<TextureSpan>                spans(height);
+    std::uniform_int_distribution<uint32_t> coordinate(0, 0xffffffff);
+    std::uniform_int_distribution<int>      step(-0x30000, 0x30000);
+    for(auto& span : spans)
+    {
+        const auto du = static_cast<uint32_t>(step(random));
+        const auto dv = static_cast<uint32_t>(step(random));
+        span          = {flat.data(), 6, 6, coordinate(random), coordinate(random), du, dv};
+    }
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+
+    const std::vector<std::pair<string, SpanDrawer::DrawFunction>> kernels {{"SpanDrawer::DrawScalar", SpanDrawer::DrawScalar},
+                                                                           {"SpanDrawer::DrawAVX2", SpanDrawer::DrawAVX2}};
+    for(const auto& [name, kernel] : kernels)
+    {
+        if(kernel == SpanDrawer::DrawAVX2 && !SpanDrawer::HasAVX2())
+        {
+            cout << name << " skipped, CPU has no AVX2" << endl;
+            continue;
+        }
+        Measure(options, name, [&, kernel = kernel](Timer& timer) {
+            timer.Start();
+            for(int y = 0; y < height; y++)
+            {
+                kernel(spans[y], width, colors.data(), pixels.data() + static_cast<size_t>(y) * width);
+            }
+            timer.Stop();
+            return Work {static_cast<size_t>(height), static_cast<size_t>(width) * height};
+        });
+    }
+
+    // the vector kernel has to match the scalar one exactly, including spans not a multiple of 8 long
+    if(SpanDrawer::HasAVX2() && (options.filter.empty() || string("SpanDrawer::DrawAVX2").find(options.filter) != string::npos))
+    {
+        std::vector<uint32_t> scalarPixels(width), vectorPixels(width);
+        size_t                numMismatches = 0;
+        for(int y = 0; y < height; y++)
+        {
+            const auto numPixels = width - y % 8;
+            SpanDrawer::DrawScalar(spans[y], numPixels, colors.data(), scalarPixels.data());
+            SpanDrawer::DrawAVX2(spans[y], numPixels, colors.data(), vectorPixels.data());
+            numMismatches += !std::equal(scalarPixels.begin(), scalarPixels.begin() + numPixels, vectorPixels.begin());
+        }
+        cout << "    spans differing from DrawScalar: " << numMismatches << " of " << height << endl;
+    }
+}
+
+// short spans over many flats that do not fit in the cache, walked at a texel per pixel at different angles:
+// row-major flats cross a cache line on every step going up or down, tiled ones about as often at any angle
+void BenchmarkFlatLayout(const Options& options, std::mt19937& random)
+{
+    constexpr int s_numFlats   = 1024;
+    constexpr int s_spanLength = 64;
+    constexpr int s_flatBits   = 6;
+    constexpr int s_flatSize   = 1 << s_flatBits;
+
+    std::vector<unsigned char>         rows(s_numFlats * s_flatSize * s_flatSize + Texture::s_padding);
+    std::vector<unsigned char>         tiles(rows.size());
+    std::vector<uint32_t>              colors(256);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for(auto& t : rows)
+    {
+        t = static_cast<unsigned char>(byte(random));
+    }
+    for(auto& c : colors)
+    {
+        c = static_cast<uint32_t>(byte(random)) << 16 | static_cast<uint32_t>(byte(random)) << 8 | byte(random);
+    }
+    for(auto f = 0; f < s_numFlats; f++)
+    {
+        const auto flat = static_cast<size_t>(f) * s_flatSize * s_flatSize;
+        for(auto y = 0; y < s_flatSize; y++)
+        {
+            for(auto x = 0; x < s_flatSize; x++)
+            {
+                tiles[flat + TextureSpan::TiledOffset(x, y, s_flatBits)] = rows[flat + y * s_flatSize + x];
+            }
+        }
+    }
+
+    // flats in a random order so that the prefetcher cannot run ahead
+    std::vector<int> order(s_numFlats);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), random);
+
+    const auto                              drawSpan = SpanDrawer::Select();
+    std::vector<uint32_t>                   pixels(s_spanLength);
+    std::uniform_int_distribution<uint32_t> coordinate(0, 0xffffffff);
+    for(const auto tiled : {false, true})
+    {
+        for(auto degrees = 0; degrees <= 90; degrees += 15)
+        {
+            const auto radians = degrees * PI / 180.0f;
+            const auto du      = static_cast<uint32_t>(static_cast<int32_t>(cosf(radians) * SpanDrawer::s_fracUnit));
+            const auto dv      = static_cast<uint32_t>(static_cast<int32_t>(sinf(radians) * SpanDrawer::s_fracUnit));
+            std::vector<TextureSpan> spans(s_numFlats);
+            for(auto i = 0; i < s_numFlats; i++)
+            {
+                const auto pixels = (tiled ? tiles : rows).data() + static_cast<size_t>(order[i]) * s_flatSize * s_flatSize;
+                spans[i]          = {pixels, s_flatBits, s_flatBits, coordinate(random), coordinate(random), du, dv, tiled};
+            }
+
+            const auto name = string(tiled ? "tiled" : "row-major") + " flat spans at " + std::to_string(degrees) + " degrees";
+            Measure(options, name, [&](Timer& timer) {
+                timer.Start();
+                for(const auto& span : spans)
+                {
+                    drawSpan(span, s_spanLength, colors.data(), pixels.data());
+                }
+                timer.Stop();
+                return Work {spans.size(), spans.size() * s_spanLength};
+            });
+        }
+    }
+}
+
+void BenchmarkPainter(const Options& options, FrameBuffer32& frameBuffer, const WADFile& wadFile)
+{
+    const auto width  = frameBuffer.m_width;
+    const auto height = frameBuffer.m_height;
+
+    Thing          pov {0, 0, 45, 0};
+    Projection     projection {pov, frameBuffer};
+    TexturePainter painter {frameBuffer, pov, projection, wadFile};
+
+    const auto wallTexture = FindTexture(wadFile.m_textures, options.wallTexture);
+    if(wallTexture.has_value())
+    {
+        Frame::PainterContext context;
+        context.textureId = wadFile.TextureId(wallTexture.value());
+        context.yScale    = 0.5f;
+        context.isEdge    = false;
+        context.lightness = 0.7f;
+        const Frame::Span span {0, height - 1};
+
+        Measure(options, "TexturePainter::PaintWall (" + wallTexture.value() + ")", [&](Timer& timer) {
+            timer.Start();
+            for(int x = 0; x < width; x++)
+            {
+                context.texelX = static_cast<float>(x);
+                painter.PaintWall(x, span, context);
+            }
+            timer.Stop();
+            return Work {static_cast<size_t>(width), static_cast<size_t>(width) * height};
+        });
+    }
+
+    const auto flatTexture = FindTexture(wadFile.m_textures, options.flatTexture);
+    if(flatTexture.has_value())
+    {
+        // floor below eye level covering the bottom half of the screen
+        const auto   textureName = flatTexture.value();
+        Frame::Plane plane {-pov.z, wadFile.TextureId(textureName), 0.7f, height};
+        size_t       numPixels = 0;
+        for(int y = height / 2 + 1; y < height; y++)
+        {
+            plane.spans[y].emplace_back(0, width - 1);
+            numPixels += width;
+        }
+
+        Measure(options, "TexturePainter::PaintPlane (" + textureName + ")", [&](Timer& timer) {
+            timer.Start();
+            painter.PaintPlane(plane);
+            timer.Stop();
+            return Work {1, numPixels};
+        });
+    }
+
+    if(wadFile.m_textures.find("SKY1") != wadFile.m_textures.end())
+    {
+        Frame::Plane sky {NAN, wadFile.TextureId("SKY1"), 1.0f, height};
+        size_t       numPixels = 0;
+        for(int x = 0; x < width; x++)
+        {
+            sky.addSpan(x, 0, height / 2 - 1);
+            numPixels += height / 2;
+        }
+
+        Measure(options, "TexturePainter::PaintPlane (sky)", [&](Timer& timer) {
+            timer.Start();
+            painter.PaintPlane(sky);
+            timer.Stop();
+            return Work {1, numPixels};
+        });
+    }
+
+    const auto spriteTexture = FindTexture(wadFile.m_sprites, options.spriteTexture);
+    if(spriteTexture.has_value())
+    {
+        Frame::PainterContext context;
+        context.sprite    = wadFile.m_sprites.at(spriteTexture.value()).get();
+        context.yScale    = 0.25f;
+        context.isEdge    = false;
+        context.lightness = 0.7f;
+
+        // sprite partially hidden behind a wall
+        std::vector<bool> occlusion(height, false);
+        std::fill(occlusion.begin() + height * 3 / 4, occlusion.end(), true);
+
+        Measure(options, "TexturePainter::PaintSprite (" + spriteTexture.value() + ")", [&](Timer& timer) {
+            timer.Start();
+            for(int x = 0; x < width; x++)
+            {
+                context.texelX = x * 0.25f;
+                painter.PaintSprite(x, 0, occlusion, context);
+            }
+            timer.Stop();
+            return Work {static_cast<size_t>(width), static_cast<size_t>(width) * height};
+        });
+    }
+}
+
+void BenchmarkFrame(const Options& options, FrameBuffer32& frameBuffer, std::mt19937& random)
+{
+    const auto width  = frameBuffer.m_width;
+    const auto height = frameBuffer.m_height;
+
+    // segments in BSP order are mostly narrow, solid walls eventually cover the screen
+    struct HorizontalSegment
+    {
+        int  startX;
+        int  endX;
+        bool isSolid;
+    };
+    std::vector<HorizontalSegment>     segments(1024);
+    std::uniform_int_distribution<int> startX(-width / 8, width);
+    std::uniform_int_distribution<int> segmentWidth(1, width / 6);
+    std::bernoulli_distribution        isSolid(0.6);
+    for(auto& segment : segments)
+    {
+        segment.startX  = startX(random);
+        segment.endX    = segment.startX + segmentWidth(random);
+        segment.isSolid = isSolid(random);
+    }
+
+    Measure(options, "Frame::ClipHorizontalSegment", [&](Timer& timer) {
+        Frame  frame {frameBuffer};
+        size_t numCalls = 0;
+        int    numSpans = 0;
+        timer.Start();
+        for(const auto& segment : segments)
+        {
+            numSpans += static_cast<int>(frame.ClipHorizontalSegment(segment.startX, segment.endX, segment.isSolid).size());
+            numCalls++;
+            if(frame.IsOccluded())
+            {
+                break;
+            }
+        }
+        timer.Stop();
+        s_intSink = numSpans;
+        return Work {numCalls, 0};
+    });
+
+    // walls stacked in front of each other, each one narrowing the open window
+    constexpr int                      numWalls = 8;
+    std::vector<std::pair<int, int>>   projections(static_cast<size_t>(width) * numWalls);
+    std::uniform_int_distribution<int> ceilingStep(0, height / (numWalls * 2));
+    std::uniform_int_distribution<int> floorStep(0, height / (numWalls * 2));
+    for(int x = 0; x < width; x++)
+    {
+        int ceiling = -1;
+        int floor   = height;
+        for(int w = 0; w < numWalls; w++)
+        {
+            ceiling += ceilingStep(random);
+            floor -= floorStep(random);
+            projections[w * width + x] = std::make_pair(ceiling, floor);
+        }
+    }
+    const float ceilingHeight    = 128;
+    const float floorHeight      = 0;
+    const int   ceilingTextureId = 0;
+    const int   floorTextureId   = 1;
+
+    Measure(options, "Frame::ClipVerticalSegment", [&](Timer& timer) {
+        Frame frame {frameBuffer};
+        int   visible = 0;
+        timer.Start();
+        for(int w = 0; w < numWalls; w++)
+        {
+            for(int x = 0; x < width; x++)
+            {
+                const auto& [ceiling, floor] = projections[w * width + x];
+                const auto span              = frame.ClipVerticalSegment(
+                    x, ceiling, floor, w == numWalls - 1, &ceilingHeight, &floorHeight, ceilingTextureId, floorTextureId, 0.5f + w * 0.05f);
+                visible += span.length();
+            }
+        }
+        timer.Stop();
+        s_intSink = visible;
+        return Work {static_cast<size_t>(width) * numWalls, 0};
+    });
+
+    Measure(options, "Frame::Plane::addSpan", [&](Timer& timer) {
+        Frame::Plane plane {0, floorTextureId, 1.0f, height};
+        size_t       numPixels = 0;
+        timer.Start();
+        for(int x = 0; x < width; x++)
+        {
+            const auto sy = projections[x].second;
+            plane.addSpan(x, sy, height - 1);
+            numPixels += height - sy;
+        }
+        timer.Stop();
+        return Work {static_cast<size_t>(width), numPixels};
+    });
+
+    // rows of a visplane built from several wall openings, some of them adjacent
+    std::vector<std::vector<Frame::Span>> rows(256);
+    std::uniform_int_distribution<int>    numSpans(1, 16);
+    std::uniform_int_distribution<int>    spanStart(0, width - 1);
+    std::uniform_int_distribution<int>    spanLength(0, width / 16);
+    for(auto& row : rows)
+    {
+        const auto n = numSpans(random);
+        for(int i = 0; i < n; i++)
+        {
+            const auto s = spanStart(random);
+            row.emplace_back(s, std::min(width - 1, s + spanLength(random)));
+        }
+    }
+
+    Measure(options, "TexturePainter::MergeSpans", [&](Timer& timer) {
+        size_t merged = 0;
+        timer.Start();
+        for(const auto& row : rows)
+        {
+            merged += SpanMerger::MergeSpans(row).size();
+        }
+        timer.Stop();
+        s_intSink = static_cast<int>(merged);
+        return Work {rows.size(), 0};
+    });
+}
+
+// largest differences between the float projection and its 16.16 fixed point variants over typical inputs
+void BenchmarkFixedProjection(const Options& options, FrameBuffer32& frameBuffer)
+{
+    const string name = "Projection::ViewYFixed";
+    if(!options.filter.empty() && name.find(options.filter) == string::npos)
+    {
+        return;
+    }
+
+    Thing      pov {0, 0, 0, 0.3f};
+    Projection projection {pov, frameBuffer};
+
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> distance(s_minDistance, 4096.0f);
+    std::uniform_real_distribution<float> height(-512.0f, 512.0f);
+    std::uniform_real_distribution<float> angle(-PI, PI);
+    std::uniform_real_distribution<float> viewAngle(-PI4, PI4);
+    std::uniform_int_distribution<int>    row(0, frameBuffer.m_height - 1);
+
+    std::vector<std::pair<float, float>> inputs(4096);
+    for(auto& [d, h] : inputs)
+    {
+        d = distance(random);
+        h = height(random);
+    }
+    Measure(options, "Projection::ViewY", [&](Timer& timer) {
+        int sum = 0;
+        timer.Start();
+        for(const auto& [d, h] : inputs)
+        {
+            sum += projection.ViewY(d, h);
+        }
+        timer.Stop();
+        s_intSink = sum;
+        return Work {inputs.size(), 0};
+    });
+    Measure(options, name, [&](Timer& timer) {
+        std::vector<std::pair<Fixed, Fixed>> fixedInputs(inputs.size());
+        std::transform(inputs.begin(), inputs.end(), fixedInputs.begin(), [](const auto& input) {
+            return std::make_pair(Fixed::FromFloat(input.first), Fixed::FromFloat(input.second));
+        });
+        int sum = 0;
+        timer.Start();
+        for(const auto& [d, h] : fixedInputs)
+        {
+            sum += projection.ViewYFixed(d, h);
+        }
+        timer.Stop();
+        s_intSink = sum;
+        return Work {inputs.size(), 0};
+    });
+
+    constexpr int s_numPoints = 1 << 16;
+    int           viewYMax    = 0;
+    double        scaleMax = 0, planeMax = 0, distanceMax = 0, offsetMax = 0;
+    for(int i = 0; i < s_numPoints; i++)
+    {
+        const auto d      = distance(random);
+        const auto h      = height(random);
+        const auto y      = row(random);
+        const auto fixedD = Fixed::FromFloat(d);
+        const auto fixedH = Fixed::FromFloat(h);
+        viewYMax          = std::max(viewYMax, abs(projection.ViewY(d, h) - projection.ViewYFixed(fixedD, fixedH)));
+        scaleMax          = std::max<double>(scaleMax, fabs(projection.TextureScale(d) - projection.TextureScaleFixed(fixedD).ToFloat()));
+
+        // planes closer than the minimum distance are not painted, distances beyond 32767 saturate
+        const auto planeDistance = projection.PlaneDistance(y, h);
+        if(planeDistance > s_minDistance && planeDistance < 32767.0f)
+        {
+            const auto planeFixed = projection.PlaneDistanceFixed(y, fixedH).ToFloat();
+            planeMax              = std::max<double>(planeMax, fabs(planeDistance - planeFixed) / planeDistance);
+        }
+
+        // walls seen at less than about 5 degrees are too distorted to be textured sensibly anyway
+        const Vector normal {angle(random), distance(random) / 8};
+        const auto   a            = viewAngle(random);
+        const auto   relative     = Projection::NormalizeAngle(normal.a - PI - (pov.a + a));
+        const auto   wallDistance = projection.Distance(normal, a);
+        if(fabs(cos(relative)) > 0.1f && wallDistance > s_minDistance && wallDistance < 32767.0f)
+        {
+            distanceMax = std::max<double>(distanceMax, fabs(wallDistance - projection.DistanceFixed(normal, a).ToFloat()) / wallDistance);
+            // offsets are texel columns, so their error is in texels
+            const auto offset = projection.Offset(normal, a);
+            if(fabs(offset) < 32767.0f)
+            {
+                offsetMax = std::max<double>(offsetMax, fabs(offset - projection.OffsetFixed(normal, a).ToFloat()));
+            }
+        }
+    }
+    cout << "    max difference: ViewY " << viewYMax << " px, TextureScale " << std::scientific << std::setprecision(2) << scaleMax
+         << ", relative PlaneDistance " << planeMax << ", Distance " << distanceMax << ", Offset " << offsetMax << " texels"
+         << std::defaultfloat << endl;
+}
+
+// wall columns stepped across the screen against projecting each column from its view angle
+void BenchmarkWallStepping(const Options& options, FrameBuffer32& frameBuffer)
+{
+    Thing      pov {0, 0, 0, 0.3f};
+    Projection projection {pov, frameBuffer};
+
+    std::mt19937                          random(4);
+    std::uniform_real_distribution<float> distance(s_minDistance, 512.0f);
+    std::uniform_real_distribution<float> height(-512.0f, 512.0f);
+    std::uniform_real_distribution<float> angle(-PI, PI);
+
+    std::vector<Vector> walls(256);
+    for(auto& wall : walls)
+    {
+        wall = Vector(angle(random), distance(random));
+    }
+    const auto   width = frameBuffer.m_width;
+    const auto   h     = height(random);
+    const size_t calls = walls.size() * width;
+
+    Measure(options, "Projection::ProjectWall", [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto& wall : walls)
+        {
+            for(auto x = 0; x < width; x++)
+            {
+                const auto column = projection.ProjectWall(wall, projection.ViewAngle(x));
+                sum += column.Distance() + column.Offset() + projection.ViewY(column, h) + projection.ViewY(column, -h);
+            }
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {calls, 0};
+    });
+    Measure(options, "Projection::StepWall", [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto& wall : walls)
+        {
+            auto column = projection.StepWall(wall, 0);
+            for(auto x = 0; x < width; x++, column.Step())
+            {
+                sum += column.Distance() + column.Offset() + projection.ViewY(column, h) + projection.ViewY(column, -h);
+            }
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {calls, 0};
+    });
+
+    if(!options.filter.empty() && string("Projection::StepWall").find(options.filter) == string::npos)
+    {
+        return;
+    }
+
+    // both against each other and against each column's view ray intersected with the wall segment in double precision,
+    // walls seen at less than about 5 degrees are too distorted to be textured sensibly anyway, and up to 30 degrees
+    // the table lookups of ProjectWall are a few texels off
+    constexpr double s_minCosine   = 0.1;
+    constexpr double s_checkCosine = 0.5;
+    struct Errors
+    {
+        int    viewY    = 0;
+        double distance = 0;
+        double offset   = 0;
+    } stepErrors, projectErrors, differences;
+    const auto Add = [](Errors& errors, double distance, double offset, int viewY, double expectedDistance, double expectedOffset, int expectedY) {
+        errors.distance = std::max(errors.distance, fabs(distance - expectedDistance) / expectedDistance);
+        errors.offset   = std::max(errors.offset, fabs(offset - expectedOffset));
+        errors.viewY    = std::max(errors.viewY, abs(viewY - expectedY));
+    };
+
+    std::uniform_real_distribution<float> coordinate(-512.0f, 512.0f);
+    const auto                            midX           = width / 2;
+    size_t                                numColumns[2]  = {0, 0};
+    size_t                                numDisagreeing = 0;
+    for(auto i = 0; i < 1024; i++)
+    {
+        const Line line {Vertex {coordinate(random), coordinate(random)}, Vertex {coordinate(random), coordinate(random)}};
+        const auto normal       = projection.NormalVector(line);
+        const auto normalOffset = projection.NormalOffset(line);
+        const auto sx           = static_cast<double>(line.s.x) - pov.x;
+        const auto sy           = static_cast<double>(line.s.y) - pov.y;
+        const auto dx           = static_cast<double>(line.e.x) - line.s.x;
+        const auto dy           = static_cast<double>(line.e.y) - line.s.y;
+        const auto length       = sqrt(dx * dx + dy * dy);
+        const auto side         = dx * sy - dy * sx < 0 ? 0 : 1;
+
+        // NormalVector's table lookups are off by about 4e-4 of the distance to the line's start,
+        // which is most of the distance for lines passing right next to the player
+        if(fabs(dx * sy - dy * sx) / length < 32)
+        {
+            continue;
+        }
+
+        // like the renderer, stepping starts at the first column where the segment is visible and ends after the last one
+        std::optional<Projection::WallColumn> stepped;
+        for(auto x = 0; x < width; x++)
+        {
+            if(stepped)
+            {
+                stepped->Step();
+            }
+
+            // the view ray is (cos, sin) * r from the player and meets the line at start + (dx, dy) * u
+            const auto viewAngle = atan(static_cast<double>(x - midX) / midX * PI4);
+            const auto rx        = cos(pov.a + viewAngle);
+            const auto ry        = sin(pov.a + viewAngle);
+            const auto cross     = rx * dy - ry * dx;
+            const auto r         = (sx * dy - sy * dx) / cross;
+            const auto u         = (sx * ry - sy * rx) / cross;
+            if(!(r > 0 && u >= 0 && u <= 1))
+            {
+                if(stepped)
+                {
+                    break;
+                }
+                continue;
+            }
+            if(!stepped)
+            {
+                stepped = projection.StepWall(normal, x);
+            }
+
+            const auto cosine   = fabs(cross) / length;
+            const auto distance = r * cos(viewAngle);
+            if(cosine < s_minCosine || distance < s_minDistance || distance > 32767.0)
+            {
+                continue;
+            }
+            const auto offset        = u * length;
+            const auto viewY         = projection.ViewY(static_cast<float>(distance), h);
+            const auto projected     = projection.ProjectWall(normal, projection.ViewAngle(x));
+            const auto stepOffset    = normalOffset + stepped->Offset();
+            const auto projectOffset = normalOffset + projected.Offset();
+            const auto stepY         = projection.ViewY(*stepped, h);
+            const auto projectY      = projection.ViewY(projected.Distance(), h);
+            Add(stepErrors, stepped->Distance(), stepOffset, stepY, distance, offset, viewY);
+            Add(projectErrors, projected.Distance(), projectOffset, projectY, distance, offset, viewY);
+            Add(differences, stepped->Distance(), stepOffset, stepY, projected.Distance(), projectOffset, projectY);
+
+            numColumns[side]++;
+            if(cosine > s_checkCosine && fabs(stepOffset - projectOffset) > 1)
+            {
+                numDisagreeing++;
+            }
+        }
+    }
+    const auto Print = [](const string& name, const Errors& errors) {
+        cout << "    " << name << ": ViewY " << errors.viewY << " px, relative Distance " << std::scientific << std::setprecision(2)
+             << errors.distance << ", Offset " << errors.offset << " texels" << std::defaultfloat << endl;
+    };
+    cout << "    columns seen from either side of a wall: " << numColumns[0] << " and " << numColumns[1] << endl;
+    Print("max error of StepWall", stepErrors);
+    Print("max error of ProjectWall", projectErrors);
+    Print("max difference", differences);
+    if(numDisagreeing)
+    {
+        throw std::runtime_error("StepWall and ProjectWall offsets differ by more than a texel in " + std::to_string(numDisagreeing) +
+                                 " columns seen at more than 30 degrees");
+    }
+}
+
+// compares a MathCache function against libm over the given domain
+template <typename Cached, typename Reference>
+void BenchmarkMathFunction(const Options& options,
+                           const string&  name,
+                           const string&  libmName,
+                           float          minValue,
+                           float          maxValue,
+                           Cached         cached,
+                           float (*libm)(float),
+                           Reference      reference)
+{
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> input(minValue, maxValue);
+    std::vector<float>                    inputs(4096);
+    for(auto& v : inputs)
+    {
+        v = input(random);
+    }
+
+    Measure(options, "MathCache::" + name, [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto v : inputs)
+        {
+            sum += cached(v);
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {inputs.size(), 0};
+    });
+
+    Measure(options, libmName, [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto v : inputs)
+        {
+            sum += libm(v);
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {inputs.size(), 0};
+    });
+
+    if(!options.filter.empty() && ("MathCache::" + name).find(options.filter) == string::npos)
+    {
+        return;
+    }
+
+    // errors against double precision over evenly spaced samples
+    constexpr int s_numPoints = 1 << 20;
+    double        cachedMax = 0, cachedSum = 0, libmMax = 0, libmSum = 0;
+    for(int i = 0; i < s_numPoints; i++)
+    {
+        const auto v           = minValue + (maxValue - minValue) * i / static_cast<float>(s_numPoints);
+        const auto expected    = reference(static_cast<double>(v));
+        const auto cachedError = fabs(cached(v) - expected);
+        const auto libmError   = fabs(libm(v) - expected);
+        cachedMax              = std::max(cachedMax, cachedError);
+        libmMax                = std::max(libmMax, libmError);
+        cachedSum += cachedError;
+        libmSum += libmError;
+    }
+    cout << "    max/mean error: MathCache " << std::scientific << std::setprecision(2) << cachedMax << " / " << cachedSum / s_numPoints
+         << ", " << libmName << " " << libmMax << " / " << libmSum / s_numPoints << std::defaultfloat << endl;
+}
+
+void BenchmarkMathCache(const Options& options)
+{
+    const auto& mathCache = MathCache::instance();
+
+    BenchmarkMathFunction(
+        options, "Cos", "cosf", 0, 2 * PI, [&](float v) { return mathCache.Cos(v); }, cosf, [](double v) { return cos(v); });
+    BenchmarkMathFunction(
+        options, "Sin", "sinf", 0, 2 * PI, [&](float v) { return mathCache.Sin(v); }, sinf, [](double v) { return sin(v); });
+    BenchmarkMathFunction(
+        options, "Tan", "tanf", -PI4, PI4, [&](float v) { return mathCache.Tan(v); }, tanf, [](double v) { return tan(v); });
+    BenchmarkMathFunction(
+        options, "ArcTan", "atanf", -PI4, PI4, [&](float v) { return mathCache.ArcTan(v); }, atanf, [](double v) { return atan(v); });
+
+    // two-argument version over the unit square
+    std::mt19937                          random(2);
+    std::uniform_real_distribution<float> input(-1, 1);
+    std::vector<std::pair<float, float>>  inputs(4096);
+    for(auto& [dy, dx] : inputs)
+    {
+        dy = input(random);
+        dx = input(random);
+    }
+
+    Measure(options, "MathCache::ArcTan(dy, dx)", [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto& [dy, dx] : inputs)
+        {
+            sum += mathCache.ArcTan(dy, dx);
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {inputs.size(), 0};
+    });
+
+    Measure(options, "atan2f", [&](Timer& timer) {
+        float sum = 0;
+        timer.Start();
+        for(const auto& [dy, dx] : inputs)
+        {
+            sum += atan2f(dy, dx);
+        }
+        timer.Stop();
+        s_floatSink = sum;
+        return Work {inputs.size(), 0};
+    });
+
+    if(options.filter.empty() || string("MathCache::ArcTan(dy, dx)").find(options.filter) != string::npos)
+    {
+        // angles are compared around the circle, binary angles return -PI where atan2 returns PI
+        double cachedMax = 0, cachedSum = 0;
+        for(const auto& [dy, dx] : inputs)
+        {
+            const auto difference = mathCache.ArcTan(dy, dx) - atan2(static_cast<double>(dy), static_cast<double>(dx));
+            const auto error      = fabs(remainder(difference, 2.0 * PI));
+            cachedMax        = std::max(cachedMax, error);
+            cachedSum += error;
+        }
+        cout << "    max/mean error: MathCache " << std::scientific << std::setprecision(2) << cachedMax << " / "
+             << cachedSum / inputs.size() << std::defaultfloat << endl;
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if(argc > 1 && (string(argv[1]) == "--help" || string(argv[1]) == "-h"))
+        {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        }
+
+        const auto options = ParseOptions(argc, argv);
+
+        std::unique_ptr<WADFile> wadFile;
+        if(!options.wadFileName.empty())
+        {
+            wadFile = std::make_unique<WADFile>(options.wadFileName);
+        }
+
+        const auto palette = wadFile ? wadFile->m_palette : SyntheticPalette();
+
+        FrameBuffer32         frameBuffer {options.width, options.height, palette, wadFile ? wadFile->m_colorMap.get() : nullptr};
+        std::vector<uint32_t> pixels(static_cast<size_t>(options.width) * options.height);
+        frameBuffer.Attach(pixels.data(), []() {});
+
+        std::mt19937 random(7);
+
+        cout << "rtdoom kernelbench: " << options.width << "x" << options.height << ", MathCache::s_useCache = " << std::boolalpha
+             << MathCache::s_useCache << std::noboolalpha << endl;
+        cout << std::left << std::setw(44) << "kernel" << std::right << std::setw(12) << "ns/call" << std::setw(12) << "ns/pixel" << endl;
+
+        BenchmarkFrameBuffer(options, frameBuffer, random);
+        BenchmarkColumnFrameBuffer(options, palette, wadFile ? wadFile->m_colorMap.get() : nullptr, random);
+        BenchmarkSpanDrawer(options, random);
+        BenchmarkFlatLayout(options, random);
+        if(wadFile)
+        {
+            BenchmarkPainter(options, frameBuffer, *wadFile);
+        }
+        else
+        {
+            cout << "(no WAD file given, skipping TexturePainter kernels)" << endl;
+        }
+        BenchmarkFrame(options, frameBuffer, random);
+        BenchmarkMathCache(options);
+        BenchmarkFixedProjection(options, frameBuffer);
+        BenchmarkWallStepping(options, frameBuffer);
+    }
+    catch(std::exception& ex)
+    {
+        cout << "Exception: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,402 @@
+#include "pch.h"
+
+#include <iomanip>
+
+#include "rtdoom.h"
+#include "WADFile.h"
+#include "GameState.h"
+#include "SoftwareRenderer.h"
+#include "FrameBuffer32.h"
+#include "Projection.h"
+#include "Demo.h"
+#include "Helpers.h"
+
+using namespace rtdoom;
+using std::cout, std::endl, std::string;
+
+namespace
+{
+struct Options
+{
+    string                  wadFileName;
+    std::vector<string>     mapNames;
+    string                  outputPrefix = "mapsweep";
+    Renderer::RenderingMode mode         = Renderer::RenderingMode::Textured;
+    int                     width        = 640;
+    int                     height       = 400;
+    int                     gridSize     = 128;
+    int                     numAngles    = 8;
+    int                     repeats      = 3;
+    int                     numWorst     = 10;
+    int                     imageScale   = 4;
+};
+
+// player needs this much room between floor and ceiling, cells in lower sectors are skipped
+constexpr float s_playerHeight = 56;
+// same as GameState::ClipPlayer
+constexpr float s_eyeHeight = 45;
+
+// a single rendered viewpoint
+struct Sample
+{
+    Thing      pose;
+    double     frameTime;
+    FrameStats stats;
+};
+
+void PrintUsage()
+{
+    cout << "Usage: mapsweep [options] [file.wad]" << endl
+         << "  --maps LIST       comma-separated maps to sweep (default: all)" << endl
+         << "  --mode NAME       wireframe, solid, textured or overdraw (default: textured)" << endl
+         << "  --res WxH         resolution to render at (default: 640x400)" << endl
+         << "  --grid N          size of grid cells in map units (default: 128)" << endl
+         << "  --angles N        view angles rendered in each cell (default: 8)" << endl
+         << "  --repeats N       renders of each viewpoint, the fastest is kept (default: 3)" << endl
+         << "  --worst N         number of worst viewpoints to report (default: 10)" << endl
+         << "  --scale N         heatmap pixels per grid cell (default: 4)" << endl
+         << "  --out PREFIX      prefix of the output files (default: mapsweep)" << endl;
+}
+
+Options ParseOptions(int argc, char** argv)
+{
+    Options options;
+    for(int i = 1; i < argc; i++)
+    {
+        const string arg(argv[i]);
+        if(arg.size() < 2 || arg.substr(0, 2) != "--")
+        {
+            options.wadFileName = arg;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        const string value(argv[++i]);
+        if(arg == "--maps")
+        {
+            options.mapNames = Helpers::Split(value, ',');
+        }
+        else if(arg == "--mode")
+        {
+            const auto mode = Renderer::ParseMode(value);
+            if(!mode.has_value())
+            {
+                throw std::runtime_error("Unknown rendering mode " + value);
+            }
+            options.mode = *mode;
+        }
+        else if(arg == "--res")
+        {
+            const auto separator = value.find('x');
+            if(separator == string::npos)
+            {
+                throw std::runtime_error("Invalid resolution " + value);
+            }
+            options.width  = std::stoi(value.substr(0, separator));
+            options.height = std::stoi(value.substr(separator + 1));
+            if(options.width <= 0 || options.height <= 0)
+            {
+                throw std::runtime_error("Invalid resolution " + value);
+            }
+        }
+        else if(arg == "--grid")
+        {
+            options.gridSize = std::max(8, std::stoi(value));
+        }
+        else if(arg == "--angles")
+        {
+            options.numAngles = std::max(1, std::stoi(value));
+        }
+        else if(arg == "--repeats")
+        {
+            options.repeats = std::max(1, std::stoi(value));
+        }
+        else if(arg == "--worst")
+        {
+            options.numWorst = std::max(0, std::stoi(value));
+        }
+        else if(arg == "--scale")
+        {
+            options.imageScale = std::max(1, std::stoi(value));
+        }
+        else if(arg == "--out")
+        {
+            options.outputPrefix = value;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+// blue for the cheapest cells through green and yellow to red for the most expensive one
+uint32_t HeatColor(double value)
+{
+    const std::array<uint32_t, 4> colors {0x000040ff, 0x0000c000, 0x00f0f000, 0x00ff0000};
+
+    const auto position = std::clamp(value, 0.0, 1.0) * (colors.size() - 1);
+    const auto index    = std::min(static_cast<size_t>(position), colors.size() - 2);
+    const auto fraction = position - index;
+
+    uint32_t color = 0;
+    for(auto shift = 0; shift < 24; shift += 8)
+    {
+        const auto from = (colors[index] >> shift) & 0xff;
+        const auto to   = (colors[index + 1] >> shift) & 0xff;
+        color |= static_cast<uint32_t>(from + (static_cast<double>(to) - from) * fraction) << shift;
+    }
+    return color;
+}
+
+// 24-bit uncompressed .bmp, rows are stored bottom-up which matches map coordinates
+void WriteBitmap(const string& fileName, int width, int height, const std::vector<uint32_t>& pixels)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file.good())
+    {
+        throw std::runtime_error("Unable to write file " + fileName);
+    }
+
+    const auto rowSize   = (width * 3 + 3) & ~3;
+    const auto imageSize = rowSize * height;
+    const auto write     = [&file](uint32_t value, int numBytes) {
+        for(auto b = 0; b < numBytes; b++)
+        {
+            file.put(static_cast<char>((value >> (b * 8)) & 0xff));
+        }
+    };
+
+    // BITMAPFILEHEADER
+    file.write("BM", 2);
+    write(14 + 40 + imageSize, 4);
+    write(0, 4);
+    write(14 + 40, 4);
+    // BITMAPINFOHEADER
+    write(40, 4);
+    write(width, 4);
+    write(height, 4);
+    write(1, 2);
+    write(24, 2);
+    write(0, 4);
+    write(imageSize, 4);
+    write(2835, 4);
+    write(2835, 4);
+    write(0, 4);
+    write(0, 4);
+
+    for(auto y = 0; y < height; y++)
+    {
+        for(auto x = 0; x < width; x++)
+        {
+            write(pixels[y * width + x], 3);
+        }
+        write(0, rowSize - width * 3);
+    }
+}
+
+std::vector<Sample> SweepMap(const Options& options, const string& mapName, const MapStore& mapStore, const WADFile& wadFile)
+{
+    GameState        gameState;
+    SoftwareRenderer renderer {gameState, wadFile};
+    FrameBuffer32    frameBuffer {options.width, options.height, wadFile.m_palette, wadFile.m_colorMap.get()};
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(options.width) * options.height);
+    frameBuffer.Attach(pixels.data(), []() {});
+    renderer.SetMode(options.mode);
+    gameState.NewGame(mapStore, wadFile);
+    const auto& mapDef = *gameState.m_mapDef;
+
+    // grid covering all of the map's lines
+    float minX = std::numeric_limits<float>::max(), minY = minX, maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+    for(const auto& line : mapDef.m_wireframe)
+    {
+        minX = std::min({minX, line.s.x, line.e.x});
+        minY = std::min({minY, line.s.y, line.e.y});
+        maxX = std::max({maxX, line.s.x, line.e.x});
+        maxY = std::max({maxY, line.s.y, line.e.y});
+    }
+    const auto gridSize   = static_cast<float>(options.gridSize);
+    const auto numColumns = std::max(1, static_cast<int>(std::ceil((maxX - minX) / gridSize)));
+    const auto numRows    = std::max(1, static_cast<int>(std::ceil((maxY - minY) / gridSize)));
+
+    // render every pose a few times and keep the fastest to filter out noise
+    renderer.RenderFrame(frameBuffer);
+    std::vector<Sample> samples;
+    std::vector<double> cellTimes(static_cast<size_t>(numColumns) * numRows, -1);
+    for(auto row = 0; row < numRows; row++)
+    {
+        for(auto column = 0; column < numColumns; column++)
+        {
+            const auto x      = minX + (column + 0.5f) * gridSize;
+            const auto y      = minY + (row + 0.5f) * gridSize;
+            const auto sector = mapDef.GetSector(Point(x, y));
+            if(!sector.has_value() || sector->ceilingHeight - sector->floorHeight < s_playerHeight)
+            {
+                continue;
+            }
+
+            for(auto a = 0; a < options.numAngles; a++)
+            {
+                const Thing pose {x, y, sector->floorHeight + s_eyeHeight, Projection::NormalizeAngle(a * 2 * PI / options.numAngles)};
+                Demo::Play(Demo::Step(pose), gameState);
+
+                Sample sample {pose, std::numeric_limits<double>::max(), FrameStats()};
+                for(auto r = 0; r < options.repeats; r++)
+                {
+                    const auto startTime = std::chrono::steady_clock::now();
+                    renderer.RenderFrame(frameBuffer);
+                    const auto frameTime =
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                    if(frameTime < sample.frameTime)
+                    {
+                        sample.frameTime = frameTime;
+                        sample.stats     = renderer.GetFrameStats();
+                    }
+                }
+
+                auto& cellTime = cellTimes[row * numColumns + column];
+                cellTime       = std::max(cellTime, sample.frameTime);
+                samples.push_back(sample);
+            }
+        }
+    }
+
+    // heatmap of the worst angle in each cell with the map's lines on top, unreachable cells are black
+    const auto worstCell   = *std::max_element(cellTimes.begin(), cellTimes.end());
+    const auto imageWidth  = numColumns * options.imageScale;
+    const auto imageHeight = numRows * options.imageScale;
+    std::vector<uint32_t> image(static_cast<size_t>(imageWidth) * imageHeight);
+    for(auto py = 0; py < imageHeight; py++)
+    {
+        for(auto px = 0; px < imageWidth; px++)
+        {
+            const auto cellTime = cellTimes[(py / options.imageScale) * numColumns + px / options.imageScale];
+            image[py * imageWidth + px] = cellTime < 0 ? 0 : HeatColor(worstCell > 0 ? cellTime / worstCell : 0);
+        }
+    }
+    const auto scale = options.imageScale / gridSize;
+    for(const auto& line : mapDef.m_wireframe)
+    {
+        const auto sx    = (line.s.x - minX) * scale;
+        const auto sy    = (line.s.y - minY) * scale;
+        const auto dx    = (line.e.x - minX) * scale - sx;
+        const auto dy    = (line.e.y - minY) * scale - sy;
+        const auto steps = std::max(1, static_cast<int>(std::max(std::abs(dx), std::abs(dy))));
+        for(auto s = 0; s <= steps; s++)
+        {
+            const auto px = static_cast<int>(sx + dx * s / steps);
+            const auto py = static_cast<int>(sy + dy * s / steps);
+            if(px >= 0 && py >= 0 && px < imageWidth && py < imageHeight)
+            {
+                image[py * imageWidth + px] = 0x00c0c0c0;
+            }
+        }
+    }
+    WriteBitmap(options.outputPrefix + "_" + mapName + ".bmp", imageWidth, imageHeight, image);
+
+    cout << mapName << ": " << numColumns << "x" << numRows << " cells of " << options.gridSize << ", " << samples.size()
+         << " viewpoints" << endl;
+    return samples;
+}
+
+void WriteSamples(const string& fileName, const string& mapName, const std::vector<Sample>& samples)
+{
+    std::ofstream csvFile(fileName);
+    if(!csvFile.good())
+    {
+        throw std::runtime_error("Unable to write file " + fileName);
+    }
+    csvFile << "map,x,y,z,angle,frame_ms,segments,visplanes,floor_planes,ceiling_planes,sprites,subsectors,pixels,texels" << endl;
+    for(const auto& sample : samples)
+    {
+        const auto& stats = sample.stats;
+        csvFile << mapName << "," << sample.pose.x << "," << sample.pose.y << "," << sample.pose.z << "," << sample.pose.a << ","
+                << sample.frameTime << "," << stats.numSegments << "," << stats.numVisplanes << "," << stats.numFloorPlanes << ","
+                << stats.numCeilingPlanes << "," << stats.numSprites << "," << stats.numSubSectors << "," << stats.numPixels << ","
+                << stats.numTexels << endl;
+    }
+}
+
+// list the most expensive viewpoints and save them as a demo that timedemo can replay
+void ReportWorst(const Options& options, const string& mapName, std::vector<Sample> samples)
+{
+    const auto numWorst = std::min(samples.size(), static_cast<size_t>(options.numWorst));
+    std::partial_sort(samples.begin(), samples.begin() + numWorst, samples.end(), [](const Sample& a, const Sample& b) {
+        return a.frameTime > b.frameTime;
+    });
+
+    Demo demo;
+    demo.m_mapName = mapName;
+    cout << "  " << std::right << std::setw(9) << "x" << std::setw(9) << "y" << std::setw(7) << "angle" << std::setw(10) << "ms"
+         << std::setw(7) << "segs" << std::setw(10) << "visplanes" << std::setw(9) << "sprites" << endl;
+    for(size_t i = 0; i < numWorst; i++)
+    {
+        const auto& sample = samples[i];
+        cout << "  " << std::fixed << std::setprecision(0) << std::setw(9) << sample.pose.x << std::setw(9) << sample.pose.y
+             << std::setw(7) << sample.pose.a * 180 / PI << std::setprecision(3) << std::setw(10) << sample.frameTime << std::setw(7)
+             << sample.stats.numSegments << std::setw(10) << sample.stats.numVisplanes << std::setw(9) << sample.stats.numSprites
+             << std::defaultfloat << endl;
+        demo.RecordPose(sample.pose);
+    }
+    demo.Save(options.outputPrefix + "_" + mapName + "_worst.txt");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if(argc > 1 && (string(argv[1]) == "--help" || string(argv[1]) == "-h"))
+        {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        }
+
+        auto options = ParseOptions(argc, argv);
+        if(options.wadFileName.empty())
+        {
+            const auto wadFileName = Helpers::FindWAD();
+            if(!wadFileName.has_value())
+            {
+                throw std::runtime_error("No WAD file found! Pass a .wad file or drop one off to the current directory.");
+            }
+            options.wadFileName = wadFileName.value();
+        }
+
+        WADFile wadFile(options.wadFileName);
+        if(options.mapNames.empty())
+        {
+            for(const auto& [mapName, mapStore] : wadFile.m_maps)
+            {
+                options.mapNames.push_back(mapName);
+            }
+        }
+
+        for(const auto& mapName : options.mapNames)
+        {
+            const auto mapIter = wadFile.m_maps.find(mapName);
+            if(mapIter == wadFile.m_maps.end())
+            {
+                throw std::runtime_error("Map " + mapName + " not found");
+            }
+
+            const auto samples = SweepMap(options, mapName, mapIter->second, wadFile);
+            if(samples.empty())
+            {
+                continue;
+            }
+            WriteSamples(options.outputPrefix + "_" + mapName + ".csv", mapName, samples);
+            ReportWorst(options, mapName, samples);
+        }
+    }
+    catch(std::exception& ex)
+    {
+        cout << "Exception: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
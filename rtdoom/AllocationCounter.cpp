@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+
+#include <new>
+
+namespace rtdoom
+{
+// per thread so the tracer's writer and other threads don't show up in frame counts
+static thread_local AllocationCounter::Values s_allocations;
+
+AllocationCounter::Values AllocationCounter::Read()
+{
+    return s_allocations;
+}
+
+void AllocationCounter::Add(size_t numBytes)
+{
+    s_allocations.numAllocations++;
+    s_allocations.numBytes += numBytes;
+}
+} // namespace rtdoom
+
+#if defined(RTDOOM_COUNT_ALLOCATIONS)
+// replacements for the global allocation functions, over-aligned variants are left to the runtime and not counted
+void* operator new(size_t size)
+{
+    rtdoom::AllocationCounter::Add(size);
+    while(true)
+    {
+        if(void* p = std::malloc(size ? size : 1))
+        {
+            return p;
+        }
+
+        // like the default one, give the new handler a chance to free memory before failing
+        const auto newHandler = std::get_new_handler();
+        if(newHandler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        newHandler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+#endif
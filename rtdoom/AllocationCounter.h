@@ -0,0 +1,37 @@
+#pragma once
+
+namespace rtdoom
+{
+// heap allocations made by the calling thread, counted by the global operator new replacement in AllocationCounter.cpp,
+// which is only compiled in with RTDOOM_COUNT_ALLOCATIONS defined (timedemo), otherwise the counts stay at zero
+class AllocationCounter
+{
+public:
+#if defined(RTDOOM_COUNT_ALLOCATIONS)
+    constexpr static bool s_isEnabled = true;
+#else
+    constexpr static bool s_isEnabled = false;
+#endif
+
+    struct Values
+    {
+        size_t numAllocations = 0;
+        size_t numBytes       = 0;
+
+        Values operator-(const Values& rhs) const
+        {
+            return Values {numAllocations - rhs.numAllocations, numBytes - rhs.numBytes};
+        }
+        Values& operator+=(const Values& rhs)
+        {
+            numAllocations += rhs.numAllocations;
+            numBytes += rhs.numBytes;
+            return *this;
+        }
+    };
+
+    // running totals since the thread started
+    static Values Read();
+    static void   Add(size_t numBytes);
+};
+} // namespace rtdoom
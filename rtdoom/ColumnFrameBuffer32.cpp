@@ -0,0 +1,217 @@
+#include "pch.h"
+#include "ColumnFrameBuffer32.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+namespace rtdoom
+{
+ColumnFrameBuffer32::ColumnFrameBuffer32(int width, int height, const Palette& palette, const ColorMap* colorMap) :
+    FrameBuffer32 {width, height, palette, colorMap}, m_columns(width * height)
+{}
+
+// drawing goes to the columns, Clear is inherited and clears them as well
+void ColumnFrameBuffer32::Attach(void* pixels, std::function<void()> stepCallback)
+{
+    m_target       = reinterpret_cast<uint32_t*>(pixels);
+    m_pixels       = reinterpret_cast<Pixel32*>(m_columns.data());
+    m_stepCallback = stepCallback;
+}
+
+void ColumnFrameBuffer32::VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept
+{
+    if(x >= 0 && x < m_width)
+    {
+        sy = std::max(0, std::min(sy, m_height - 1));
+        ey = std::max(0, std::min(ey, m_height - 1));
+        if(sy > ey)
+        {
+            std::swap(sy, ey);
+        }
+
+        const auto color  = FlatColor(colorIndex % s_colors.size(), lightness);
+        const auto column = &m_columns[m_height * x];
+        std::fill(column + sy, column + ey + 1, color);
+        m_numPixels += ey - sy + 1;
+        m_stepCallback();
+    }
+}
+
+void ColumnFrameBuffer32::VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept
+{
+    if(x >= 0 && x < m_width && texels.size() && sy < m_height)
+    {
+        const auto colors = LitColors(lightness);
+        const auto column = &m_columns[m_height * x];
+        for(const auto t : texels)
+        {
+            if(t != 247 && sy >= 0)
+            {
+                column[sy] = colors[t];
+                m_numPixels++;
+            }
+            sy++;
+            if(sy == m_height)
+            {
+                break;
+            }
+        }
+        m_stepCallback();
+    }
+}
+
+void ColumnFrameBuffer32::VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept
+{
+    if(x >= 0 && x < m_width && texels.size())
+    {
+        auto offset        = m_height * x + sy;
+        auto lightnessIter = lightnesses.begin();
+        for(const auto t : texels)
+        {
+            m_columns[offset++] = LitColors(*lightnessIter++)[t];
+        }
+        m_numPixels += texels.size();
+        m_stepCallback();
+    }
+}
+
+// columns are already contiguous here, so they are painted one by one
+void ColumnFrameBuffer32::VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept
+{
+    FrameBuffer::VerticalLines(x, numColumns, columns);
+}
+
+void ColumnFrameBuffer32::HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept
+{
+    if(y >= 0 && y < m_height && texels.size())
+    {
+        const auto colors = LitColors(lightness);
+        auto       offset = m_height * sx + y;
+        for(const auto t : texels)
+        {
+            m_columns[offset] = colors[t];
+            offset += m_height;
+        }
+        m_numPixels += texels.size();
+        m_stepCallback();
+    }
+}
+
+void ColumnFrameBuffer32::HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept
+{
+    if(y >= 0 && y < m_height && sx >= 0 && ex < m_width)
+    {
+        const auto color  = FlatColor(colorIndex, lightness);
+        auto       offset = m_height * sx + y;
+        for(auto x = sx; x <= ex; x++)
+        {
+            m_columns[offset] = color;
+            offset += m_height;
+        }
+        m_numPixels += ex - sx + 1;
+        m_stepCallback();
+    }
+}
+
+void ColumnFrameBuffer32::HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept
+{
+    if(y >= 0 && y < m_height && sx >= 0 && ex < m_width && sx <= ex)
+    {
+        const auto colors    = LitColors(lightness);
+        const auto numPixels = ex - sx + 1;
+        auto       offset    = m_height * sx + y;
+        for(auto i = 0; i < numPixels; i++)
+        {
+            m_columns[offset] = colors[span.Texel(i)];
+            offset += m_height;
+        }
+        m_numPixels += numPixels;
+        m_stepCallback();
+    }
+}
+
+void ColumnFrameBuffer32::SetPixel(int x, int y, int colorIndex, float lightness) noexcept
+{
+    if(x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        m_columns[m_height * x + y] = LitColors(lightness)[colorIndex];
+        m_numPixels++;
+    }
+}
+
+void ColumnFrameBuffer32::SetColor(int x, int y, uint32_t argb) noexcept
+{
+    if(x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        m_columns[m_height * x + y] = argb;
+        m_numPixels++;
+    }
+}
+
+// columns sx..ex-1 and rows sy..ey-1 into the target, mirrored horizontally like FrameBuffer32 draws
+void ColumnFrameBuffer32::Transpose(int sx, int ex, int sy, int ey) noexcept
+{
+    auto x = sx;
+#if defined(_M_X64) || defined(__x86_64__)
+    // 4x4 pixel tiles: four column loads, an unpack transpose, and four row stores reversed for the mirroring
+    for(; x + 4 <= ex; x += 4)
+    {
+        auto y = sy;
+        for(; y + 4 <= ey; y += 4)
+        {
+            const auto c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_columns[m_height * x + y]));
+            const auto c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_columns[m_height * (x + 1) + y]));
+            const auto c2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_columns[m_height * (x + 2) + y]));
+            const auto c3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_columns[m_height * (x + 3) + y]));
+
+            const auto t0 = _mm_unpacklo_epi32(c0, c1);
+            const auto t1 = _mm_unpacklo_epi32(c2, c3);
+            const auto t2 = _mm_unpackhi_epi32(c0, c1);
+            const auto t3 = _mm_unpackhi_epi32(c2, c3);
+
+            const __m128i rows[4] {
+                _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+            for(auto r = 0; r < 4; r++)
+            {
+                const auto target = &m_target[m_width * (y + r) + (m_width - x - 4)];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm_shuffle_epi32(rows[r], _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+        }
+        for(; y < ey; y++)
+        {
+            for(auto dx = 0; dx < 4; dx++)
+            {
+                m_target[m_width * y + (m_width - x - dx - 1)] = m_columns[m_height * (x + dx) + y];
+            }
+        }
+    }
+#endif
+    for(; x < ex; x++)
+    {
+        for(auto y = sy; y < ey; y++)
+        {
+            m_target[m_width * y + (m_width - x - 1)] = m_columns[m_height * x + y];
+        }
+    }
+}
+
+// the transpose goes block by block so that both the columns read and the rows written stay in cache
+void ColumnFrameBuffer32::Flush() noexcept
+{
+    constexpr int s_blockSize = 32;
+    if(m_target == nullptr)
+    {
+        return;
+    }
+    for(auto y = 0; y < m_height; y += s_blockSize)
+    {
+        for(auto x = 0; x < m_width; x += s_blockSize)
+        {
+            Transpose(x, std::min(x + s_blockSize, m_width), y, std::min(y + s_blockSize, m_height));
+        }
+    }
+}
+
+ColumnFrameBuffer32::~ColumnFrameBuffer32() {}
+} // namespace rtdoom
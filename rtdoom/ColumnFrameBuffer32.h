@@ -0,0 +1,34 @@
+#pragma once
+
+#include "FrameBuffer32.h"
+
+namespace rtdoom
+{
+// 32-bit frame buffer drawing into its own column-major pixels, so that wall and sprite columns are contiguous,
+// and transposing them into the attached row-major pixels in Flush
+class ColumnFrameBuffer32 : public FrameBuffer32
+{
+protected:
+    // pixel (x, y) is at m_columns[x * m_height + y], columns are not mirrored
+    std::vector<uint32_t> m_columns;
+    uint32_t*             m_target {nullptr};
+
+    void Transpose(int sx, int ex, int sy, int ey) noexcept;
+
+public:
+    virtual void Attach(void* pixels, std::function<void()> stepCallback) override;
+    virtual void SetPixel(int x, int y, int color, float lightness) noexcept override;
+    virtual void SetColor(int x, int y, uint32_t argb) noexcept override;
+    virtual void VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept override;
+    virtual void HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept override;
+    virtual void HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept override;
+    virtual void Flush() noexcept override;
+
+    ColumnFrameBuffer32(int width, int height, const Palette& palette, const ColorMap* colorMap = nullptr);
+    ~ColumnFrameBuffer32();
+};
+} // namespace rtdoom
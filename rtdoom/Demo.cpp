@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "Demo.h"
+#include "Projection.h"
+
+namespace rtdoom
+{
+void Demo::RecordMove(int moveDirection, int rotateDirection, float seconds)
+{
+    m_steps.emplace_back(moveDirection, rotateDirection, seconds);
+}
+
+void Demo::RecordPose(const Thing& pose)
+{
+    m_steps.emplace_back(pose);
+}
+
+void Demo::Clear()
+{
+    m_mapName.clear();
+    m_steps.clear();
+}
+
+void Demo::Load(const std::string& fileName)
+{
+    std::ifstream infile(fileName);
+    if(!infile.good())
+    {
+        throw std::runtime_error("Unable to open file " + fileName);
+    }
+
+    Clear();
+    std::string line;
+    while(std::getline(infile, line))
+    {
+        std::istringstream input(line);
+        std::string        command;
+        if(!(input >> command) || command[0] == '#')
+        {
+            continue;
+        }
+
+        if(command == "map")
+        {
+            input >> m_mapName;
+        }
+        else if(command == "move")
+        {
+            int   m, r;
+            float seconds;
+            if(!(input >> m >> r >> seconds))
+            {
+                throw std::runtime_error("Invalid demo step: " + line);
+            }
+            RecordMove(m, r, seconds);
+        }
+        else if(command == "pose")
+        {
+            float x, y, z;
+            Angle a;
+            if(!(input >> x >> y >> z >> a))
+            {
+                throw std::runtime_error("Invalid demo step: " + line);
+            }
+            RecordPose(Thing(x, y, z, a));
+        }
+        else
+        {
+            throw std::runtime_error("Unknown demo command: " + command);
+        }
+    }
+}
+
+void Demo::Save(const std::string& fileName) const
+{
+    std::ofstream outfile(fileName);
+    if(!outfile.good())
+    {
+        throw std::runtime_error("Unable to write file " + fileName);
+    }
+
+    outfile.precision(9);
+    if(!m_mapName.empty())
+    {
+        outfile << "map " << m_mapName << std::endl;
+    }
+    for(const auto& step : m_steps)
+    {
+        if(step.isPose)
+        {
+            outfile << "pose " << step.pose.x << " " << step.pose.y << " " << step.pose.z << " " << step.pose.a << std::endl;
+        }
+        else
+        {
+            outfile << "move " << step.moveDirection << " " << step.rotateDirection << " " << step.seconds << std::endl;
+        }
+    }
+}
+
+void Demo::Play(const Step& step, GameState& gameState)
+{
+    if(step.isPose)
+    {
+        gameState.m_player.x = step.pose.x;
+        gameState.m_player.y = step.pose.y;
+        gameState.m_player.z = step.pose.z;
+        gameState.m_player.a = Projection::NormalizeAngle(step.pose.a);
+    }
+    else
+    {
+        gameState.Move(step.moveDirection, step.rotateDirection, step.seconds);
+        gameState.ClipPlayer();
+    }
+}
+
+Demo Demo::Turnaround(const std::string& mapName, const Thing& position, int numSteps)
+{
+    Demo demo;
+    demo.m_mapName = mapName;
+    for(int i = 0; i < numSteps; i++)
+    {
+        demo.RecordPose(Thing(position.x, position.y, position.z, position.a + PI * 2.0f * i / numSteps));
+    }
+    return demo;
+}
+
+Demo::Demo() {}
+
+Demo::~Demo() {}
+} // namespace rtdoom
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "GameState.h"
+
+namespace rtdoom
+{
+// recorded camera path that can be replayed without a window, stored as text:
+//   map <name>
+//   move <moveDirection> <rotateDirection> <seconds>
+//   pose <x> <y> <z> <angle>
+class Demo
+{
+public:
+    struct Step
+    {
+        Step(int moveDirection, int rotateDirection, float seconds) :
+            isPose {false}, moveDirection {moveDirection}, rotateDirection {rotateDirection}, seconds {seconds}, pose {0, 0, 0, 0}
+        {}
+        Step(const Thing& pose) : isPose {true}, moveDirection {0}, rotateDirection {0}, seconds {0}, pose {pose} {}
+
+        bool  isPose;
+        int   moveDirection;
+        int   rotateDirection;
+        float seconds;
+        Thing pose;
+    };
+
+    std::string       m_mapName;
+    std::vector<Step> m_steps;
+
+    void RecordMove(int moveDirection, int rotateDirection, float seconds);
+    void RecordPose(const Thing& pose);
+    void Clear();
+
+    void Load(const std::string& fileName);
+    void Save(const std::string& fileName) const;
+
+    // advances the game state by a single step of the demo
+    static void Play(const Step& step, GameState& gameState);
+
+    // full turn around the given position, used when no recording is available
+    static Demo Turnaround(const std::string& mapName, const Thing& position, int numSteps);
+
+    Demo();
+    ~Demo();
+};
+} // namespace rtdoom
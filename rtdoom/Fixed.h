@@ -0,0 +1,82 @@
+#pragma once
+
+namespace rtdoom
+{
+// 16.16 fixed point number, covers -32768..32767 in steps of 1/65536, results out of range saturate
+struct Fixed
+{
+    static constexpr int     s_fracBits = 16;
+    static constexpr int32_t s_one      = 1 << s_fracBits;
+
+    int32_t raw;
+
+    static constexpr Fixed FromRaw(int64_t raw) noexcept
+    {
+        return {static_cast<int32_t>(std::max<int64_t>(INT32_MIN, std::min<int64_t>(INT32_MAX, raw)))};
+    }
+    static constexpr Fixed FromInt(int v) noexcept
+    {
+        return FromRaw(static_cast<int64_t>(v) * s_one);
+    }
+    static Fixed FromFloat(float v) noexcept
+    {
+        return FromRaw(static_cast<int64_t>(std::max(-32768.0f, std::min(32767.0f, v)) * s_one));
+    }
+
+    constexpr float ToFloat() const noexcept
+    {
+        return static_cast<float>(raw) / s_one;
+    }
+
+    // rounds towards negative infinity, unlike a float to int cast
+    constexpr int ToInt() const noexcept
+    {
+        return raw >> s_fracBits;
+    }
+
+    constexpr Fixed Abs() const noexcept
+    {
+        return FromRaw(raw < 0 ? -static_cast<int64_t>(raw) : raw);
+    }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) noexcept
+    {
+        return FromRaw(static_cast<int64_t>(a.raw) + b.raw);
+    }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) noexcept
+    {
+        return FromRaw(static_cast<int64_t>(a.raw) - b.raw);
+    }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) noexcept
+    {
+        return FromRaw((static_cast<int64_t>(a.raw) * b.raw) >> s_fracBits);
+    }
+    friend constexpr Fixed operator*(Fixed a, int b) noexcept
+    {
+        return FromRaw(static_cast<int64_t>(a.raw) * b);
+    }
+
+    // division by zero saturates towards the sign of the dividend
+    friend constexpr Fixed operator/(Fixed a, Fixed b) noexcept
+    {
+        if(b.raw == 0)
+        {
+            return FromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+        }
+        return FromRaw((static_cast<int64_t>(a.raw) * s_one) / b.raw);
+    }
+    friend constexpr Fixed operator/(Fixed a, int b) noexcept
+    {
+        return b ? FromRaw(a.raw / b) : FromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+    }
+
+    friend constexpr bool operator<(Fixed a, Fixed b) noexcept
+    {
+        return a.raw < b.raw;
+    }
+    friend constexpr bool operator>(Fixed a, Fixed b) noexcept
+    {
+        return a.raw > b.raw;
+    }
+};
+} // namespace rtdoom
@@ -1,125 +1,100 @@
 #include "pch.h"
 #include "Frame.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 using std::vector;
 using std::deque;
 using std::string;
 
 namespace rtdoom
 {
+namespace
+{
+// index of the lowest set bit, bits must not be zero
+int LowestBit(uint64_t bits) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+} // namespace
+
 Frame::Frame(const FrameBuffer& frameBuffer) :
-    m_width {frameBuffer.m_width}, m_height {frameBuffer.m_height}, m_floorClip(frameBuffer.m_width + 1, frameBuffer.m_height),
-    m_ceilClip(frameBuffer.m_width + 1, -1)
+    m_width {frameBuffer.m_width}, m_height {frameBuffer.m_height}, m_occlusion((frameBuffer.m_width + 63) / 64),
+    m_floorClip(frameBuffer.m_width + 1, frameBuffer.m_height), m_ceilClip(frameBuffer.m_width + 1, -1)
 {}
 
 // for a horizontal mapSegment, determine which columns will be visible based on already occludded map
 // if the mapSegment is isSolid, update occlussion map otherwise only clip
-vector<Frame::Span> Frame::ClipHorizontalSegment(int startX, int endX, bool isSolid)
+const vector<Frame::Span>& Frame::ClipHorizontalSegment(int startX, int endX, bool isSolid)
 {
-    vector<Frame::Span> visibleSpans;
+    m_visibleSpans.clear();
 
     startX = std::max(startX, 0);
     endX   = std::max(endX, 0);
     startX = std::min(startX, m_width);
     endX   = std::min(endX, m_width);
-    if(startX == endX)
-    {
-        return visibleSpans;
-    }
 
-    if(m_occlusion.empty())
+    // visible spans run from a visible column to the next occluded one, like occlusion spans they end where the next one starts
+    auto x = startX;
+    while(x < endX)
     {
-        visibleSpans.push_back(Frame::Span(startX, endX));
+        const auto s = FindColumn(x, endX, false);
+        if(s == endX)
+        {
+            break;
+        }
+        const auto e = FindColumn(s, endX, true);
+        m_visibleSpans.push_back(Frame::Span(s, e));
         if(isSolid)
         {
-            m_occlusion.push_front(Frame::Span(startX, endX));
+            Occlude(s, e);
         }
+        x = e;
     }
-    else
-    {
-        auto eo = m_occlusion.begin();
-        do
-        {
-            if(eo->s >= endX)
-            {
-                // doesn't overlap
-                visibleSpans.push_back(Frame::Span(startX, endX));
-                if(isSolid)
-                {
-                    m_occlusion.insert(eo, Frame::Span(startX, endX));
-                }
-                startX = endX;
-                break;
-            }
-            if(eo->e < startX)
-            {
-                continue;
-            }
-            if(eo->s <= startX && eo->e >= endX)
-            {
-                // completely covered
-                startX = endX;
-                break;
-            }
-            if(eo->s < startX)
-            {
-                // occlusion starts before us, roll start point
-                startX = std::min(endX, eo->e);
-            }
-            else if(eo->s > startX)
-            {
-                // show and occlude left part
-                visibleSpans.push_back(Frame::Span(startX, eo->s));
-                if(isSolid)
-                {
-                    eo->s = startX;
-                }
-                startX = std::min(endX, eo->e);
-            }
-            if(eo->e >= endX)
-            {
-                // completely covered
-                startX = endX;
-                break;
-            }
-            else if(eo->e < endX)
-            {
-                startX = eo->e;
-            }
-        } while(++eo != m_occlusion.end() && startX != endX);
 
-        if(endX > startX)
-        {
-            visibleSpans.push_back(Frame::Span(startX, endX));
-            if(isSolid)
-            {
-                m_occlusion.push_back(Frame::Span(startX, endX));
-            }
-        }
+    return m_visibleSpans;
+}
 
-        // merge neighbouring segments
-        if(isSolid && m_occlusion.size())
+// whole words of columns that do not match are skipped at once
+int Frame::FindColumn(int x, int end, bool isOccluded) const noexcept
+{
+    while(x < end)
+    {
+        const auto word = isOccluded ? m_occlusion[x >> 6] : ~m_occlusion[x >> 6];
+        const auto bits = word >> (x & 63);
+        if(bits)
         {
-            eo = m_occlusion.begin();
-            do
-            {
-                auto pe = eo++;
-                if(eo != m_occlusion.end() && pe->e == eo->s)
-                {
-                    eo->s = pe->s;
-                    m_occlusion.erase(pe);
-                }
-            } while(eo != m_occlusion.end());
+            return std::min(end, x + LowestBit(bits));
         }
+        x = (x | 63) + 1;
     }
+    return end;
+}
 
-    return visibleSpans;
+// columns startX..endX-1, which must not be occluded yet
+void Frame::Occlude(int startX, int endX) noexcept
+{
+    m_numOccluded += endX - startX;
+    for(auto x = startX; x < endX; x = (x | 63) + 1)
+    {
+        const auto lowBit  = x & 63;
+        const auto highBit = std::min(64, endX - (x & ~63));
+        const auto mask    = (highBit == 64 ? ~0ull : (1ull << highBit) - 1) & (~0ull << lowBit);
+        m_occlusion[x >> 6] |= mask;
+    }
 }
 
 bool Frame::IsOccluded() const
 {
-    return (m_occlusion.size() == 1 && m_occlusion.begin()->s == 0 && m_occlusion.begin()->e == m_width) ||
-           m_numVerticallyOccluded >= m_width;
+    return m_numOccluded == m_width || m_numVerticallyOccluded >= m_width;
 }
 
 bool Frame::IsVerticallyOccluded(int x) const
@@ -128,33 +103,34 @@ bool Frame::IsVerticallyOccluded(int x) const
 }
 
 // add a vertical span into planes list
-void Frame::MergeIntoPlane(deque<Plane>& planes, float height, const std::string& textureName, float lightLevel, int x, int sy, int ey)
+void Frame::MergeIntoPlane(deque<Plane>& planes, float height, int textureId, float lightLevel, int x, int sy, int ey)
 {
     if(IsSpanVisible(x, sy, ey))
     {
         auto plane = std::find_if(planes.begin(), planes.end(), [&](const Plane& plane) {
             return (plane.h == height || (!isfinite(plane.h) && !isfinite(height))) && plane.lightLevel == lightLevel &&
-                   plane.textureName == textureName;
+                   plane.textureId == textureId;
         });
         if(plane == planes.end())
         {
-            planes.push_front(Plane(height, textureName, lightLevel, m_height));
+            planes.push_front(Plane(height, textureId, lightLevel, m_height));
             plane = planes.begin();
+            m_numVisplanes++;
         }
         plane->addSpan(x, std::max(sy, 0), std::min(ey, m_height - 1));
     }
 }
 
 // for a vertical mapSegment, determine which section is visible and update occlusion map
-Frame::Span Frame::ClipVerticalSegment(int                x,
-                                       int                ceilingProjection,
-                                       int                floorProjection,
-                                       bool               isSolid,
-                                       const float*       ceilingHeight,
-                                       const float*       floorHeight,
-                                       const std::string& ceilingTexture,
-                                       const std::string& floorTexture,
-                                       float              lightLevel)
+Frame::Span Frame::ClipVerticalSegment(int          x,
+                                       int          ceilingProjection,
+                                       int          floorProjection,
+                                       bool         isSolid,
+                                       const float* ceilingHeight,
+                                       const float* floorHeight,
+                                       int          ceilingTextureId,
+                                       int          floorTextureId,
+                                       float        lightLevel)
 {
     Frame::Span span;
 
@@ -168,7 +144,7 @@ Frame::Span Frame::ClipVerticalSegment(int                x,
         span.s = std::min(ceilingProjection, m_floorClip[x]);
         if(ceilingHeight)
         {
-            MergeIntoPlane(m_ceilingPlanes, *ceilingHeight, ceilingTexture, lightLevel, x, m_ceilClip[x], span.s);
+            MergeIntoPlane(m_ceilingPlanes, *ceilingHeight, ceilingTextureId, lightLevel, x, m_ceilClip[x], span.s);
         }
     }
     else
@@ -180,7 +156,7 @@ Frame::Span Frame::ClipVerticalSegment(int                x,
         span.e = std::max(floorProjection, m_ceilClip[x]);
         if(floorHeight)
         {
-            MergeIntoPlane(m_floorPlanes, *floorHeight, floorTexture, lightLevel, x, span.e, m_floorClip[x]);
+            MergeIntoPlane(m_floorPlanes, *floorHeight, floorTextureId, lightLevel, x, span.e, m_floorClip[x]);
         }
     }
     else
@@ -222,6 +198,14 @@ bool Frame::IsSpanVisible(int x, int sy, int ey) const
 // extend plane to include a vertical span
 void Frame::Plane::addSpan(int x, int sy, int ey)
 {
+    if(isSky())
+    {
+        if(sy <= ey)
+        {
+            columns.push_back({x, Span(sy, ey)});
+        }
+        return;
+    }
     for(auto y = sy; y <= ey; y++)
     {
         auto& span = spans[y];
@@ -2,6 +2,7 @@
 
 #include "FrameBuffer.h"
 #include "MapDef.h"
+#include "WADFile.h"
 
 namespace rtdoom
 {
@@ -38,35 +39,45 @@ public:
         }
     };
 
+    // vertical screen span in a single column
+    struct ColumnSpan
+    {
+        int  x;
+        Span span;
+    };
+
     // screen area covered by floor or ceiling
     struct Plane
     {
-        Plane(float h, const std::string& textureName, float lightLevel, int height) :
-            h {h}, textureName {textureName}, lightLevel {lightLevel}, spans(height)
+        Plane(float h, int textureId, float lightLevel, int height) : h {h}, textureId {textureId}, lightLevel {lightLevel}, spans(height)
         {}
         bool isSky() const
         {
             return isnan(h);
         }
-        const std::string&             textureName;
+        const int                      textureId;
         const float                    lightLevel;
         const float                    h;
         std::vector<std::vector<Span>> spans;
 
+        // sky is painted column by column, so its vertical spans are kept as added instead of being split into rows
+        std::vector<ColumnSpan> columns;
+
         void addSpan(int x, int sy, int ey);
     };
 
-    // texturing information
+    // texturing information, walls refer to a texture by id and things to their sprite patch
     struct PainterContext
     {
-        PainterContext() : yPegging {0}, yOffset {0} {}
-        std::string textureName;
-        float       yScale;
-        float       texelX;
-        int         yPegging;
-        int         yOffset;
-        bool        isEdge;
-        float       lightness;
+        PainterContext() : textureId {s_noTexture}, sprite {nullptr}, yPegging {0}, yOffset {0} {}
+        int                   textureId;
+        const WADFile::Patch* sprite;
+        float                 yScale;
+        float                 texelX;
+        int                   yPegging;
+        int                   yOffset;
+        bool                  isEdge;
+        float                 lightness;
     };
 
     // silhouette of a drawn wall
@@ -153,8 +164,12 @@ public:
     const int m_width;
     const int m_height;
 
-    // list of horizontal screen spans where isSolid walls have already been drawn (completely occluded)
-    std::list<Span> m_occlusion;
+    // one bit per screen column where isSolid walls have already been drawn (completely occluded), and their count
+    std::vector<uint64_t> m_occlusion;
+    int                   m_numOccluded = 0;
+
+    // spans returned by the last ClipHorizontalSegment, reused between calls
+    std::vector<Span> m_visibleSpans;
 
     // drawn walls that clip anything behind them
     std::list<Clip> m_clips;
@@ -171,6 +186,9 @@ public:
     int m_numFloorPlanes        = 0;
     int m_numCeilingPlanes      = 0;
     int m_numVerticallyOccluded = 0;
+    int m_numVisplanes          = 0;
+    int m_numClips              = 0;
+    int m_numSubSectors         = 0;
 
     // spaces between walls with floors and ceilings
     std::deque<Plane> m_floorPlanes;
@@ -180,21 +198,26 @@ public:
     std::unordered_set<int> m_sectors;
 
     // add vertical span to existing planes
-    void MergeIntoPlane(std::deque<Plane>& planes, float height, const std::string& textureName, float lightLevel, int x, int sy, int ey);
+    void MergeIntoPlane(std::deque<Plane>& planes, float height, int textureId, float lightLevel, int x, int sy, int ey);
+
+    // returns horizontal screen spans where the mapSegment is visible and updates occlusion table,
+    // the spans are valid until the next call
+    const std::vector<Span>& ClipHorizontalSegment(int startX, int endX, bool isSolid);
 
-    // returns horizontal screen spans where the mapSegment is visible and updates occlusion table
-    std::vector<Span> ClipHorizontalSegment(int startX, int endX, bool isSolid);
+    // first column from x up to end that is occluded or not, end if there is none
+    int  FindColumn(int x, int end, bool isOccluded) const noexcept;
+    void Occlude(int startX, int endX) noexcept;
 
     // returns the vertical screen span where the column is visible and updates occlussion table
-    Span ClipVerticalSegment(int                x,
-                             int                ceilingProjection,
-                             int                floorProjection,
-                             bool               isSolid,
-                             const float*       ceilingHeight,
-                             const float*       floorHeight,
-                             const std::string& ceilingTexture,
-                             const std::string& floorTexture,
-                             float              lightLevel);
+    Span ClipVerticalSegment(int          x,
+                             int          ceilingProjection,
+                             int          floorProjection,
+                             bool         isSolid,
+                             const float* ceilingHeight,
+                             const float* floorHeight,
+                             int          ceilingTextureId,
+                             int          floorTextureId,
+                             float        lightLevel);
 
     bool IsSpanVisible(int x, int sy, int ey) const;
     bool IsOccluded() const;
@@ -18,5 +18,28 @@ unsigned char FrameBuffer::Gamma(float lightness)
     return static_cast<unsigned char>(255.0f * (0.2f + lightness * 0.8f));
 }
 
+void FrameBuffer::VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept
+{
+    for(auto i = 0; i < numColumns; i++)
+    {
+        VerticalLine(x + i, columns[i].sy, *columns[i].texels, columns[i].lightness);
+    }
+}
+
+void FrameBuffer::HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept
+{
+    if(sx <= ex)
+    {
+        m_spanTexels.resize(ex - sx + 1);
+        for(size_t i = 0; i < m_spanTexels.size(); i++)
+        {
+            m_spanTexels[i] = span.Texel(static_cast<uint32_t>(i));
+        }
+        HorizontalLine(sx, y, m_spanTexels, lightness);
+    }
+}
+
+void FrameBuffer::Flush() noexcept {}
+
 FrameBuffer::~FrameBuffer() {}
 } // namespace rtdoom
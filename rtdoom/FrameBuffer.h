@@ -1,11 +1,27 @@
 #pragma once
 
 #include "WADFile.h"
+#include "SpanDrawer.h"
 
 namespace rtdoom
 {
+// column of texels from row sy down, adjacent ones are painted together by FrameBuffer::VerticalLines
+struct TexelColumn
+{
+    int                     sy;
+    const std::vector<int>* texels;
+    float                   lightness;
+};
+
 class FrameBuffer
 {
+protected:
+    // flat colors of the wireframe and solid views
+    const std::array<uint32_t, 6> s_colors {0x00ff000, 0x0000ff00, 0x000000ff, 0x00ff00ff, 0x0000ffff, 0x003f7f0f};
+
+    // texels of the last span painted through the generic HorizontalSpan
+    std::vector<int> m_spanTexels;
+
 public:
     FrameBuffer(int width, int height, const Palette& palette);
 
@@ -14,15 +30,28 @@ public:
     const Palette&        m_palette;
     std::function<void()> m_stepCallback;
 
+    // number of pixels drawn since the buffer was created
+    size_t m_numPixels = 0;
+
     virtual void Attach(void* pixels, std::function<void()> stepCallback = nullptr)                                          = 0;
     virtual void Clear()                                                                                                     = 0;
     virtual void SetPixel(int x, int y, int color, float lightness) noexcept                                                 = 0;
+    virtual void SetColor(int x, int y, uint32_t argb) noexcept                                                              = 0;
     virtual void VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept                               = 0;
     virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept = 0;
     virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept                       = 0;
     virtual void HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept                     = 0;
     virtual void HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept                             = 0;
 
+    // columns x to x + numColumns - 1, by default painted one by one with VerticalLine
+    virtual void VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept;
+
+    // texture span between sx and ex inclusive, by default looked up texel by texel and painted with HorizontalLine
+    virtual void HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept;
+
+    // called once the frame is complete, before the attached pixels are presented
+    virtual void Flush() noexcept;
+
     static unsigned char Gamma(float lightness);
 
     virtual ~FrameBuffer();
@@ -1,9 +1,14 @@
 #include "pch.h"
 #include "FrameBuffer32.h"
 
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 namespace rtdoom
 {
-FrameBuffer32::FrameBuffer32(int width, int height, const Palette& palette) : FrameBuffer {width, height, palette}
+FrameBuffer32::FrameBuffer32(int width, int height, const Palette& palette, const ColorMap* colorMap) :
+    FrameBuffer {width, height, palette}, m_drawSpan {SpanDrawer::Select()}
 {
     for(auto l = 0; l < 256; l++)
     {
@@ -13,6 +18,62 @@ FrameBuffer32::FrameBuffer32(int width, int height, const Palette& palette) : Fr
             c_lightMap[l][v] = static_cast<unsigned char>(static_cast<float>(v) * static_cast<float>(l) / 256.0f);
         }
     }
+    BuildLitColors(colorMap);
+}
+
+// rows are indexed by Gamma(lightness) >> m_lightShift: 256 gamma levels of the palette, or the 32 COLORMAP levels
+void FrameBuffer32::BuildLitColors(const ColorMap* colorMap)
+{
+    if(colorMap != nullptr)
+    {
+        m_lightShift = 3;
+        m_litColors.resize(ColorMap::s_numLightLevels);
+        for(auto l = 0; l < ColorMap::s_numLightLevels; l++)
+        {
+            // COLORMAP goes from brightest to darkest
+            const auto& map = colorMap->maps[ColorMap::s_numLightLevels - 1 - l];
+            for(auto i = 0; i < 256; i++)
+            {
+                const auto& color = m_palette.colors[map[i]];
+                Pixel32     pixel {};
+
+                pixel.argb8.r     = color.r;
+                pixel.argb8.g     = color.g;
+                pixel.argb8.b     = color.b;
+                m_litColors[l][i] = pixel.argb32;
+            }
+        }
+    }
+    else
+    {
+        m_lightShift = 0;
+        m_litColors.resize(256);
+        for(auto l = 0; l < 256; l++)
+        {
+            for(auto i = 0; i < 256; i++)
+            {
+                const auto& color = m_palette.colors[i];
+                Pixel32     pixel {};
+
+                pixel.argb8.r     = c_lightMap[l][color.r];
+                pixel.argb8.g     = c_lightMap[l][color.g];
+                pixel.argb8.b     = c_lightMap[l][color.b];
+                m_litColors[l][i] = pixel.argb32;
+            }
+        }
+    }
+}
+
+uint32_t FrameBuffer32::FlatColor(size_t colorIndex, float lightness) const noexcept
+{
+    const auto lightMap = c_lightMap[Gamma(lightness)];
+    Pixel32    pixel;
+
+    pixel.argb32  = s_colors[colorIndex];
+    pixel.argb8.r = lightMap[pixel.argb8.r];
+    pixel.argb8.g = lightMap[pixel.argb8.g];
+    pixel.argb8.b = lightMap[pixel.argb8.b];
+    return pixel.argb32;
 }
 
 void FrameBuffer32::Attach(void* pixels, std::function<void()> stepCallback)
@@ -38,21 +99,14 @@ void FrameBuffer32::VerticalLine(int x, int sy, int ey, int colorIndex, float li
             std::swap(sy, ey);
         }
 
-        const auto color    = s_colors.at(colorIndex % s_colors.size());
-        const auto lightMap = c_lightMap[Gamma(lightness)];
-        Pixel32    pixel;
-
-        pixel.argb32  = color;
-        pixel.argb8.r = lightMap[pixel.argb8.r];
-        pixel.argb8.g = lightMap[pixel.argb8.g];
-        pixel.argb8.b = lightMap[pixel.argb8.b];
-
-        auto offset = m_width * sy + (m_width - x - 1);
+        const auto color  = FlatColor(colorIndex % s_colors.size(), lightness);
+        auto       offset = m_width * sy + (m_width - x - 1);
         for(auto y = sy; y <= ey; y++)
         {
-            m_pixels[offset].argb32 = pixel.argb32;
+            m_pixels[offset].argb32 = color;
             offset += m_width;
         }
+        m_numPixels += ey - sy + 1;
         m_stepCallback();
     }
 }
@@ -61,18 +115,14 @@ void FrameBuffer32::VerticalLine(int x, int sy, const std::vector<int>& texels,
 {
     if(m_pixels != nullptr && x >= 0 && x < m_width && texels.size() && sy < m_height)
     {
-        const auto lightMap = c_lightMap[Gamma(lightness)];
-        auto       offset   = m_width * sy + (m_width - x - 1);
+        const auto colors = LitColors(lightness);
+        auto       offset = m_width * sy + (m_width - x - 1);
         for(const auto t : texels)
         {
             if(t != 247 && sy >= 0)
             {
-                const auto& color = m_palette.colors[t];
-                Pixel32&    pixel = m_pixels[offset];
-
-                pixel.argb8.r = lightMap[color.r];
-                pixel.argb8.g = lightMap[color.g];
-                pixel.argb8.b = lightMap[color.b];
+                m_pixels[offset].argb32 = colors[t];
+                m_numPixels++;
             }
             offset += m_width;
             sy++;
@@ -85,22 +135,124 @@ void FrameBuffer32::VerticalLine(int x, int sy, const std::vector<int>& texels,
     }
 }
 
+// rows sy to ey of a single texel column, already clipped to the screen
+void FrameBuffer32::PaintColumn(int x, int sy, int ey, const TexelColumn& column) noexcept
+{
+    const auto colors = LitColors(column.lightness);
+    auto       offset = m_width * sy + (m_width - x - 1);
+    for(auto y = sy; y <= ey; y++)
+    {
+        const auto t = (*column.texels)[y - column.sy];
+        if(t != 247)
+        {
+            m_pixels[offset].argb32 = colors[t];
+            m_numPixels++;
+        }
+        offset += m_width;
+    }
+}
+
+// rows covered by all columns are written as runs of adjacent pixels instead of one pixel per row and cache line,
+// the ragged ends where neighbouring spans differ are painted column by column
+void FrameBuffer32::VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept
+{
+    constexpr int s_maxColumns = 4;
+    if(m_pixels == nullptr || x < 0 || x + numColumns > m_width || numColumns > s_maxColumns)
+    {
+        FrameBuffer::VerticalLines(x, numColumns, columns);
+        return;
+    }
+
+    std::array<const uint32_t*, s_maxColumns> colors;
+    std::array<int, s_maxColumns>             sys;
+    std::array<int, s_maxColumns>             eys;
+
+    auto top    = 0;
+    auto bottom = m_height - 1;
+    for(auto i = 0; i < numColumns; i++)
+    {
+        colors[i] = LitColors(columns[i].lightness);
+        sys[i]    = std::max(0, columns[i].sy);
+        eys[i]    = std::min(m_height - 1, columns[i].sy + static_cast<int>(columns[i].texels->size()) - 1);
+        top       = std::max(top, sys[i]);
+        bottom    = std::min(bottom, eys[i]);
+    }
+
+    for(auto i = 0; i < numColumns; i++)
+    {
+        if(top > bottom)
+        {
+            PaintColumn(x + i, sys[i], eys[i], columns[i]);
+        }
+        else
+        {
+            PaintColumn(x + i, sys[i], top - 1, columns[i]);
+            PaintColumn(x + i, bottom + 1, eys[i], columns[i]);
+        }
+    }
+
+    // mirrored rows put column x + i at row[numColumns - 1 - i]
+    for(auto y = top; y <= bottom; y++)
+    {
+        const auto row = &m_pixels[m_width * y + (m_width - x - numColumns)].argb32;
+#if defined(_M_X64) || defined(__x86_64__)
+        if(numColumns == s_maxColumns)
+        {
+            const auto t0 = (*columns[0].texels)[y - columns[0].sy];
+            const auto t1 = (*columns[1].texels)[y - columns[1].sy];
+            const auto t2 = (*columns[2].texels)[y - columns[2].sy];
+            const auto t3 = (*columns[3].texels)[y - columns[3].sy];
+            if(t0 != 247 && t1 != 247 && t2 != 247 && t3 != 247)
+            {
+                const auto quad = _mm_setr_epi32(colors[3][t3], colors[2][t2], colors[1][t1], colors[0][t0]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row), quad);
+                m_numPixels += s_maxColumns;
+                continue;
+            }
+        }
+#endif
+        for(auto i = 0; i < numColumns; i++)
+        {
+            const auto t = (*columns[i].texels)[y - columns[i].sy];
+            if(t != 247)
+            {
+                row[numColumns - 1 - i] = colors[i][t];
+                m_numPixels++;
+            }
+        }
+    }
+    m_stepCallback();
+}
+
 void FrameBuffer32::HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept
 {
     if(m_pixels != nullptr && y >= 0 && y < m_height && texels.size())
     {
-        const auto lightMap = c_lightMap[Gamma(lightness)];
-        auto       offset   = m_width * y + (m_width - sx - 1);
+        const auto colors = LitColors(lightness);
+        auto       offset = m_width * y + (m_width - sx - 1);
         for(const auto t : texels)
         {
-            const auto& color = m_palette.colors[t];
-            Pixel32&    pixel = m_pixels[offset];
-
-            pixel.argb8.r = lightMap[color.r];
-            pixel.argb8.g = lightMap[color.g];
-            pixel.argb8.b = lightMap[color.b];
-            offset--;
+            m_pixels[offset--].argb32 = colors[t];
         }
+        m_numPixels += texels.size();
+        m_stepCallback();
+    }
+}
+
+// rows are mirrored, so the span is walked from ex back to sx for the kernel to write forwards in memory
+void FrameBuffer32::HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept
+{
+    if(m_pixels != nullptr && y >= 0 && y < m_height && sx >= 0 && ex < m_width && sx <= ex)
+    {
+        const auto numPixels = ex - sx + 1;
+        auto       reversed  = span;
+
+        reversed.u += (numPixels - 1) * span.du;
+        reversed.v += (numPixels - 1) * span.dv;
+        reversed.du = 0u - span.du;
+        reversed.dv = 0u - span.dv;
+        m_drawSpan(reversed, numPixels, LitColors(lightness), &m_pixels[m_width * y + (m_width - ex - 1)].argb32);
+        m_numPixels += numPixels;
         m_stepCallback();
     }
 }
@@ -109,19 +261,13 @@ void FrameBuffer32::HorizontalLine(int sx, int ex, int y, int colorIndex, float
 {
     if(m_pixels != nullptr && y >= 0 && y < m_height && sx >= 0 && ex < m_width)
     {
-        const auto lightMap = c_lightMap[Gamma(lightness)];
-        auto       offset   = m_width * y + (m_width - sx - 1);
+        const auto color  = FlatColor(colorIndex, lightness);
+        auto       offset = m_width * y + (m_width - sx - 1);
         for(auto x = sx; x <= ex; x++)
         {
-            const auto& color = s_colors[colorIndex];
-            Pixel32&    pixel = m_pixels[offset];
-
-            pixel.argb32  = color;
-            pixel.argb8.r = lightMap[pixel.argb8.r];
-            pixel.argb8.g = lightMap[pixel.argb8.g];
-            pixel.argb8.b = lightMap[pixel.argb8.b];
-            offset--;
+            m_pixels[offset--].argb32 = color;
         }
+        m_numPixels += ex - sx + 1;
         m_stepCallback();
     }
 }
@@ -134,15 +280,10 @@ void FrameBuffer32::VerticalLine(int x, int sy, const std::vector<int>& texels,
         auto lightnessIter = lightnesses.begin();
         for(const auto t : texels)
         {
-            const auto& color    = m_palette.colors[t];
-            Pixel32&    pixel    = m_pixels[offset];
-            const auto  lightMap = c_lightMap[Gamma(*lightnessIter++)];
-
-            pixel.argb8.r = lightMap[color.r];
-            pixel.argb8.g = lightMap[color.g];
-            pixel.argb8.b = lightMap[color.b];
+            m_pixels[offset].argb32 = LitColors(*lightnessIter++)[t];
             offset += m_width;
         }
+        m_numPixels += texels.size();
         m_stepCallback();
     }
 }
@@ -151,14 +292,18 @@ void FrameBuffer32::SetPixel(int x, int y, int colorIndex, float lightness) noex
 {
     if(m_pixels != nullptr && x >= 0 && y >= 0 && x < m_width && y < m_height)
     {
-        const auto& color    = m_palette.colors[colorIndex];
-        const auto  offset   = m_width * y + (m_width - x - 1);
-        const auto  lightMap = c_lightMap[Gamma(lightness)];
-        Pixel32&    pixel    = m_pixels[offset];
+        m_pixels[m_width * y + (m_width - x - 1)].argb32 = LitColors(lightness)[colorIndex];
+        m_numPixels++;
+    }
+}
 
-        pixel.argb8.r = lightMap[color.r];
-        pixel.argb8.g = lightMap[color.g];
-        pixel.argb8.b = lightMap[color.b];
+// unpaletted pixel for debug views
+void FrameBuffer32::SetColor(int x, int y, uint32_t argb) noexcept
+{
+    if(m_pixels != nullptr && x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        m_pixels[m_width * y + (m_width - x - 1)].argb32 = argb;
+        m_numPixels++;
     }
 }
 
@@ -24,20 +24,41 @@ class FrameBuffer32 : public FrameBuffer
 protected:
     Pixel32* m_pixels {nullptr};
 
-    const std::array<uint32_t, 6> s_colors {0x00ff000, 0x0000ff00, 0x000000ff, 0x00ff00ff, 0x0000ffff, 0x003f7f0f};
     unsigned char *c_lightMap[256];
 
+    // palette already lit and packed for every light level, so that painting a texel is a single load and store
+    std::vector<std::array<uint32_t, 256>> m_litColors;
+    int                                    m_lightShift;
+
+    // span kernel picked for the CPU at construction
+    SpanDrawer::DrawFunction m_drawSpan;
+
+    void BuildLitColors(const ColorMap* colorMap);
+    void PaintColumn(int x, int sy, int ey, const TexelColumn& column) noexcept;
+
+    // one of s_colors darkened by the gamma curve
+    uint32_t FlatColor(size_t colorIndex, float lightness) const noexcept;
+
+    const uint32_t* LitColors(float lightness) const noexcept
+    {
+        return m_litColors[Gamma(lightness) >> m_lightShift].data();
+    }
+
 public:
     virtual void Attach(void* pixels, std::function<void()> stepCallback) override;
     virtual void Clear() override;
     virtual void SetPixel(int x, int y, int color, float lightness) noexcept override;
+    virtual void SetColor(int x, int y, uint32_t argb) noexcept override;
     virtual void VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept override;
     virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept;
     virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept;
+    virtual void VerticalLines(int x, int numColumns, const TexelColumn* columns) noexcept override;
     virtual void HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept;
     virtual void HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept;
+    virtual void HorizontalSpan(int sx, int ex, int y, const TextureSpan& span, float lightness) noexcept override;
 
-    FrameBuffer32(int width, int height, const Palette& palette);
+    // lighting follows the WAD's COLORMAP when given, otherwise the palette is scaled by the gamma curve
+    FrameBuffer32(int width, int height, const Palette& palette, const ColorMap* colorMap = nullptr);
     ~FrameBuffer32();
 };
 } // namespace rtdoom
@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "FrameBuffer8.h"
+
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace rtdoom
+{
+FrameBuffer8::FrameBuffer8(int width, int height, const Palette& palette, const ColorMap* colorMap) :
+    FrameBuffer {width, height, palette}, m_indices(width * height)
+{
+    SetPalette(palette);
+    BuildLightMaps(colorMap);
+
+    for(size_t c = 0; c < s_colors.size(); c++)
+    {
+        m_flatColors[c] = NearestIndex((s_colors[c] >> 16) & 0xff, (s_colors[c] >> 8) & 0xff, s_colors[c] & 0xff);
+    }
+    m_blackIndex = NearestIndex(0, 0, 0);
+}
+
+void FrameBuffer8::BuildLightMaps(const ColorMap* colorMap)
+{
+    m_lightMaps.resize(ColorMap::s_numLightLevels);
+    for(auto l = 0; l < ColorMap::s_numLightLevels; l++)
+    {
+        if(colorMap != nullptr)
+        {
+            // COLORMAP goes from brightest to darkest
+            std::copy_n(colorMap->maps[ColorMap::s_numLightLevels - 1 - l], 256, m_lightMaps[l].begin());
+        }
+        else
+        {
+            // level l covers gamma values 8l..8l+7, the brightest one leaves the palette unchanged
+            const auto scale = (l + 1) * 8;
+            for(auto i = 0; i < 256; i++)
+            {
+                const auto& color = m_palette.colors[i];
+                m_lightMaps[l][i] = NearestIndex(color.r * scale / 256, color.g * scale / 256, color.b * scale / 256);
+            }
+        }
+    }
+}
+
+void FrameBuffer8::SetPalette(const Palette& palette)
+{
+    for(auto i = 0; i < 256; i++)
+    {
+        const auto& color = palette.colors[i];
+        m_colors[i]       = (static_cast<uint32_t>(color.r) << 16) | (static_cast<uint32_t>(color.g) << 8) | color.b;
+    }
+}
+
+uint8_t FrameBuffer8::NearestIndex(int r, int g, int b) const
+{
+    auto nearestIndex    = 0;
+    auto nearestDistance = std::numeric_limits<int>::max();
+    for(auto i = 0; i < 256; i++)
+    {
+        const auto& color    = m_palette.colors[i];
+        const auto  distance = (color.r - r) * (color.r - r) + (color.g - g) * (color.g - g) + (color.b - b) * (color.b - b);
+        if(distance < nearestDistance)
+        {
+            nearestIndex    = i;
+            nearestDistance = distance;
+        }
+    }
+    return static_cast<uint8_t>(nearestIndex);
+}
+
+uint8_t FrameBuffer8::FlatColor(int colorIndex, float lightness) const noexcept
+{
+    return LightMap(lightness)[m_flatColors[colorIndex % m_flatColors.size()]];
+}
+
+void FrameBuffer8::Attach(void* pixels, std::function<void()> stepCallback)
+{
+    m_target       = reinterpret_cast<uint32_t*>(pixels);
+    m_stepCallback = stepCallback;
+}
+
+void FrameBuffer8::Clear()
+{
+    std::fill(m_indices.begin(), m_indices.end(), m_blackIndex);
+    m_stepCallback();
+}
+
+void FrameBuffer8::VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept
+{
+    if(x >= 0 && x < m_width)
+    {
+        sy = std::max(0, std::min(sy, m_height - 1));
+        ey = std::max(0, std::min(ey, m_height - 1));
+        if(sy > ey)
+        {
+            std::swap(sy, ey);
+        }
+
+        const auto index  = FlatColor(colorIndex, lightness);
+        auto       offset = m_width * sy + (m_width - x - 1);
+        for(auto y = sy; y <= ey; y++)
+        {
+            m_indices[offset] = index;
+            offset += m_width;
+        }
+        m_numPixels += ey - sy + 1;
+        m_stepCallback();
+    }
+}
+
+void FrameBuffer8::VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept
+{
+    if(x >= 0 && x < m_width && texels.size() && sy < m_height)
+    {
+        const auto lightMap = LightMap(lightness);
+        auto       offset   = m_width * sy + (m_width - x - 1);
+        for(const auto t : texels)
+        {
+            if(t != 247 && sy >= 0)
+            {
+                m_indices[offset] = lightMap[t];
+                m_numPixels++;
+            }
+            offset += m_width;
+            sy++;
+            if(sy == m_height)
+            {
+                break;
+            }
+        }
+        m_stepCallback();
+    }
+}
+
+void FrameBuffer8::HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept
+{
+    if(y >= 0 && y < m_height && texels.size())
+    {
+        const auto lightMap = LightMap(lightness);
+        auto       offset   = m_width * y + (m_width - sx - 1);
+        for(const auto t : texels)
+        {
+            m_indices[offset--] = lightMap[t];
+        }
+        m_numPixels += texels.size();
+        m_stepCallback();
+    }
+}
+
+void FrameBuffer8::HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept
+{
+    if(y >= 0 && y < m_height && sx >= 0 && ex < m_width)
+    {
+        const auto index  = FlatColor(colorIndex, lightness);
+        auto       offset = m_width * y + (m_width - sx - 1);
+        for(auto x = sx; x <= ex; x++)
+        {
+            m_indices[offset--] = index;
+        }
+        m_numPixels += ex - sx + 1;
+        m_stepCallback();
+    }
+}
+
+void FrameBuffer8::VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept
+{
+    if(x >= 0 && x < m_width && texels.size())
+    {
+        auto offset        = m_width * sy + (m_width - x - 1);
+        auto lightnessIter = lightnesses.begin();
+        for(const auto t : texels)
+        {
+            m_indices[offset] = LightMap(*lightnessIter++)[t];
+            offset += m_width;
+        }
+        m_numPixels += texels.size();
+        m_stepCallback();
+    }
+}
+
+void FrameBuffer8::SetPixel(int x, int y, int colorIndex, float lightness) noexcept
+{
+    if(x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        m_indices[m_width * y + (m_width - x - 1)] = LightMap(lightness)[colorIndex];
+        m_numPixels++;
+    }
+}
+
+// debug views use only a handful of colors, so their nearest palette entries are looked up once
+void FrameBuffer8::SetColor(int x, int y, uint32_t argb) noexcept
+{
+    if(x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        auto nearestColor = m_nearestColors.find(argb);
+        if(nearestColor == m_nearestColors.end())
+        {
+            nearestColor = m_nearestColors.emplace(argb, NearestIndex((argb >> 16) & 0xff, (argb >> 8) & 0xff, argb & 0xff)).first;
+        }
+        m_indices[m_width * y + (m_width - x - 1)] = nearestColor->second;
+        m_numPixels++;
+    }
+}
+
+// the whole frame goes through the 1 KiB palette in one sequential pass, 8 pixels per gather where AVX2 is available
+void FrameBuffer8::Flush() noexcept
+{
+    if(m_target == nullptr)
+    {
+        return;
+    }
+
+    const auto numPixels = m_indices.size();
+    const auto indices   = m_indices.data();
+    size_t     i         = 0;
+#if defined(__AVX2__)
+    const auto colors = reinterpret_cast<const int*>(m_colors.data());
+    for(; i + 8 <= numPixels; i += 8)
+    {
+        const auto packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i));
+        const auto pixels = _mm256_i32gather_epi32(colors, _mm256_cvtepu8_epi32(packed), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_target + i), pixels);
+    }
+#else
+    for(; i + 4 <= numPixels; i += 4)
+    {
+        m_target[i]     = m_colors[indices[i]];
+        m_target[i + 1] = m_colors[indices[i + 1]];
+        m_target[i + 2] = m_colors[indices[i + 2]];
+        m_target[i + 3] = m_colors[indices[i + 3]];
+    }
+#endif
+    for(; i < numPixels; i++)
+    {
+        m_target[i] = m_colors[indices[i]];
+    }
+}
+
+FrameBuffer8::~FrameBuffer8() {}
+} // namespace rtdoom
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+namespace rtdoom
+{
+// frame buffer keeping palette indices, lit through index-to-index light maps like the original COLORMAP,
+// and expanded to ARGB8888 into the attached pixels in a single pass by Flush
+class FrameBuffer8 : public FrameBuffer
+{
+protected:
+    uint32_t*            m_target {nullptr};
+    std::vector<uint8_t> m_indices;
+
+    // palette index to palette index for each of the 32 light levels, indexed by Gamma(lightness) >> 3
+    std::vector<std::array<uint8_t, 256>> m_lightMaps;
+
+    // palette index to ARGB8888, used by the final expansion
+    std::array<uint32_t, 256> m_colors;
+
+    // nearest palette entries of the flat debug colors
+    std::array<uint8_t, 6>                m_flatColors;
+    uint8_t                               m_blackIndex;
+    std::unordered_map<uint32_t, uint8_t> m_nearestColors;
+
+    void    BuildLightMaps(const ColorMap* colorMap);
+    uint8_t NearestIndex(int r, int g, int b) const;
+    uint8_t FlatColor(int colorIndex, float lightness) const noexcept;
+
+    const uint8_t* LightMap(float lightness) const noexcept
+    {
+        return m_lightMaps[Gamma(lightness) >> 3].data();
+    }
+
+public:
+    virtual void Attach(void* pixels, std::function<void()> stepCallback) override;
+    virtual void Clear() override;
+    virtual void SetPixel(int x, int y, int color, float lightness) noexcept override;
+    virtual void SetColor(int x, int y, uint32_t argb) noexcept override;
+    virtual void VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept override;
+    virtual void Flush() noexcept override;
+
+    // swaps the colors used by the expansion only, e.g. for the whole-screen damage and pickup tints
+    void SetPalette(const Palette& palette);
+
+    // palette indices of the last frame, mirrored the same way as the expanded pixels
+    const std::vector<uint8_t>& Indices() const
+    {
+        return m_indices;
+    }
+
+    // light maps follow the WAD's COLORMAP when given, otherwise the nearest palette entry of each darkened color
+    FrameBuffer8(int width, int height, const Palette& palette, const ColorMap* colorMap = nullptr);
+    ~FrameBuffer8();
+};
+} // namespace rtdoom
@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "FrameStats.h"
+
+namespace rtdoom
+{
+const char* FrameStats::PhaseName(Phase phase)
+{
+    switch(phase)
+    {
+    case Phase::Initialize:
+        return "initialize";
+    case Phase::Segments:
+        return "segments";
+    case Phase::Planes:
+        return "planes";
+    case Phase::Sprites:
+        return "sprites";
+    case Phase::Overlay:
+        return "overlay";
+    default:
+        return "unknown";
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const FrameStats& stats)
+{
+    os << stats.frameTime << "ms (";
+    for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+    {
+        os << (p ? ", " : "") << FrameStats::PhaseName(static_cast<FrameStats::Phase>(p)) << " " << stats.phaseTimes[p] << "ms";
+    }
+    os << "): " << stats.numSegments << " segs, " << stats.numSubSectors << " subsectors, " << stats.numFloorPlanes << "+"
+       << stats.numCeilingPlanes << " planes (" << stats.numVisplanes << " visplanes), " << stats.numClips << " clips, "
+       << stats.numSprites << " sprites, " << stats.numPixels << " pixels, " << stats.numTexels << " texels";
+    if constexpr(AllocationCounter::s_isEnabled)
+    {
+        os << ", " << stats.frameAllocations.numAllocations << " allocations (" << stats.frameAllocations.numBytes << " bytes)";
+    }
+    if(stats.overdraw > 0)
+    {
+        os << ", overdraw " << stats.overdraw << " (" << stats.numOverdrawnPixels << " pixels overdrawn, up to " << stats.maxOverdraw
+           << " times)";
+    }
+    return os;
+}
+} // namespace rtdoom
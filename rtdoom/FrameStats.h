@@ -0,0 +1,71 @@
+#pragma once
+
+#include "PerfCounters.h"
+#include "AllocationCounter.h"
+
+namespace rtdoom
+{
+// timings and counters collected while rendering a single frame
+struct FrameStats
+{
+    // phases of SoftwareRenderer::RenderFrame in the order they run
+    enum class Phase
+    {
+        Initialize,
+        Segments,
+        Planes,
+        Sprites,
+        Overlay
+    };
+    static constexpr size_t s_numPhases = 5;
+
+    static const char* PhaseName(Phase phase);
+
+    // milliseconds spent in each phase and in the whole frame
+    std::array<double, s_numPhases> phaseTimes {};
+    double                          frameTime = 0;
+
+    // copied from Frame
+    int numSegments      = 0;
+    int numFloorPlanes   = 0;
+    int numCeilingPlanes = 0;
+    int numSprites       = 0;
+    int numVisplanes     = 0;
+    int numClips         = 0;
+    int numSubSectors    = 0;
+
+    // work done by painters and the frame buffer
+    size_t numPixels = 0;
+    size_t numTexels = 0;
+
+    // Overdraw mode only: average writes per drawn pixel, pixels drawn more than once and the most writes to one pixel
+    float overdraw           = 0;
+    int   numOverdrawnPixels = 0;
+    int   maxOverdraw        = 0;
+
+    // hardware counters sampled around each phase, only when SoftwareRenderer has PerfCounters attached
+    std::array<PerfCounters::Values, s_numPhases> phaseCounters {};
+    PerfCounters::Values                          frameCounters {};
+
+    // heap allocations made while rendering
+    std::array<AllocationCounter::Values, s_numPhases> phaseAllocations {};
+    AllocationCounter::Values                          frameAllocations {};
+
+    double PhaseTime(Phase phase) const
+    {
+        return phaseTimes[static_cast<size_t>(phase)];
+    }
+
+    const PerfCounters::Values& PhaseCounters(Phase phase) const
+    {
+        return phaseCounters[static_cast<size_t>(phase)];
+    }
+
+    const AllocationCounter::Values& PhaseAllocations(Phase phase) const
+    {
+        return phaseAllocations[static_cast<size_t>(phase)];
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const FrameStats& stats);
+} // namespace rtdoom
@@ -136,16 +136,16 @@ void GLContext::BindView(glm::f32* viewMat, glm::f32* projectionMat)
     glBindVertexArray(m_VAO);
 }
 
-std::shared_ptr<Texture> GLContext::AllocateTexture(std::string name, int& textureUnit, int& textureNo)
+std::shared_ptr<Texture> GLContext::AllocateTexture(int textureId, int& textureUnit, int& textureNo)
 {
     // decide which texture unit and number the texture will go to, but create them later?
-    if(name == "-")
+    if(textureId == s_noTexture)
     {
         textureUnit = 0;
         textureNo   = 0;
         return NULL;
     }
-    auto   texture = m_wadFile.m_textures.find(name)->second;
+    auto   texture = m_wadFile.m_texturesById[textureId];
     size_t tui;
     for(tui = 0; tui < m_textureUnits.size(); tui++)
     {
@@ -154,7 +154,7 @@ std::shared_ptr<Texture> GLContext::AllocateTexture(std::string name, int& textu
             textureUnit = tui;
             for(size_t tn = 0; tn < m_textureUnits[tui].textures.size(); tn++)
             {
-                if(m_textureUnits[tui].textures[tn]->name == name)
+                if(m_textureUnits[tui].textures[tn]->id == textureId)
                 {
                     textureNo = tn;
                     return texture;
@@ -180,7 +180,7 @@ std::shared_ptr<Texture> GLContext::AllocateTexture(std::string name, int& textu
     tu.h = texture->height;
     tu.n = m_textureUnits.size();
     m_textureUnits.push_back(tu);
-    return AllocateTexture(name, textureUnit, textureNo);
+    return AllocateTexture(textureId, textureUnit, textureNo);
 }
 
 void GLContext::CompileShaders(const char* vertexShaderSource, const char* fragmentShaderSource)
@@ -61,7 +61,7 @@ public:
     std::vector<unsigned int>          m_indices;
     std::map<int, std::pair<int, int>> m_subSectorOffsets;
 
-    std::shared_ptr<Texture> AllocateTexture(std::string name, int& textureNo, int& textureLayer);
+    std::shared_ptr<Texture> AllocateTexture(int textureId, int& textureNo, int& textureLayer);
     void                     Initialize();
     void                     CompileShaders(const char* vertexShaderSource, const char* fragmentShaderSource);
     void                     BindMap();
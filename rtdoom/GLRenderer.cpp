@@ -92,7 +92,7 @@ void GLRenderer::LoadMap()
             }
             if(segment->isSolid)
             {
-                texture               = m_context.AllocateTexture(segment->frontSide.middleTexture, textureUnit, textureNo);
+                texture               = m_context.AllocateTexture(segment->frontSide.middleTextureId, textureUnit, textureNo);
                 const auto texXOffset = (segment->xOffset + segment->frontSide.xOffset) / (float)texture->width;
                 const auto texYOffset = (segment->frontSide.yOffset) / (float)texture->height;
                 const auto segW       = Projection::Distance(segment->s, segment->e) / (float)texture->width;
@@ -114,9 +114,9 @@ void GLRenderer::LoadMap()
             {
                 const auto& backSector = segment->backSide.sector;
 
-                if(segment->frontSide.lowerTexture != "-" && segment->frontSide.lowerTexture != "")
+                if(segment->frontSide.lowerTextureId != s_noTexture)
                 {
-                    texture               = m_context.AllocateTexture(segment->frontSide.lowerTexture, textureUnit, textureNo);
+                    texture               = m_context.AllocateTexture(segment->frontSide.lowerTextureId, textureUnit, textureNo);
                     const auto texXOffset = (segment->xOffset + segment->frontSide.xOffset) / (float)texture->width;
                     auto       texYOffset = (segment->frontSide.yOffset) / (float)texture->height;
                     const auto segW       = Projection::Distance(segment->s, segment->e) / (float)texture->width;
@@ -140,9 +140,9 @@ void GLRenderer::LoadMap()
                                              lightness);
                 }
 
-                if(segment->frontSide.upperTexture != "-" && segment->frontSide.lowerTexture != "" && !segment->backSide.sector.isSky)
+                if(segment->frontSide.upperTextureId != s_noTexture && !segment->backSide.sector.isSky)
                 {
-                    texture               = m_context.AllocateTexture(segment->frontSide.upperTexture, textureUnit, textureNo);
+                    texture               = m_context.AllocateTexture(segment->frontSide.upperTextureId, textureUnit, textureNo);
                     const auto texXOffset = (segment->xOffset + segment->frontSide.xOffset) / (float)texture->width;
                     auto       texYOffset = (segment->frontSide.yOffset) / (float)texture->height;
                     const auto segW       = Projection::Distance(segment->s, segment->e) / (float)texture->width;
@@ -179,9 +179,9 @@ void GLRenderer::LoadMap()
                 std::shared_ptr<Texture> texture;
                 int                      textureUnit, textureNo;
                 const auto&              fanLine = *curr;
-                if(sector.floorTexture != "-")
+                if(sector.floorTextureId != s_noTexture)
                 {
-                    texture = m_context.AllocateTexture(sector.floorTexture, textureUnit, textureNo);
+                    texture = m_context.AllocateTexture(sector.floorTextureId, textureUnit, textureNo);
                     m_context.AddFloorCeiling(fanLine->e,
                                               fanLine->s,
                                               fanStart,
@@ -192,9 +192,9 @@ void GLRenderer::LoadMap()
                                               textureNo,
                                               sector.lightLevel);
                 }
-                if(sector.ceilingTexture != "-" && !sector.isSky)
+                if(sector.ceilingTextureId != s_noTexture && !sector.isSky)
                 {
-                    texture = m_context.AllocateTexture(sector.ceilingTexture, textureUnit, textureNo);
+                    texture = m_context.AllocateTexture(sector.ceilingTextureId, textureUnit, textureNo);
                     m_context.AddFloorCeiling(fanStart,
                                               fanLine->s,
                                               fanLine->e,
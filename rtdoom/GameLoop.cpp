@@ -4,13 +4,15 @@
 namespace rtdoom
 {
 GameLoop::GameLoop(SDL_Renderer* sdlRenderer, SDL_Window* window, const WADFile& wadFile) :
-    m_gameState {}, m_moveDirection {0}, m_rotateDirection {0}, m_isRunning {false}, m_stepFrame {false}, m_softwareRenderer {m_gameState,
-                                                                                                                              wadFile},
+    m_wadFile {wadFile}, m_gameState {}, m_moveDirection {0}, m_rotateDirection {0}, m_isRunning {false}, m_stepFrame {false},
+    m_softwareRenderer {m_gameState, wadFile},
     m_glRenderer {m_gameState, wadFile, s_displayX, s_displayY}, m_glViewport {window, m_glRenderer},
-    m_playerViewport {sdlRenderer, m_softwareRenderer, ViewScale(s_displayX), ViewScale(s_displayY), wadFile.m_palette, true},
+    m_playerViewport {
+        sdlRenderer, m_softwareRenderer, ViewScale(s_displayX), ViewScale(s_displayY), wadFile.m_palette, wadFile.m_colorMap.get(), true},
     m_mapRenderer {m_gameState},
-    m_mapViewport {sdlRenderer, m_mapRenderer, MapScale(s_displayX), MapScale(s_displayY), wadFile.m_palette, false},
-    m_sdlRenderer(sdlRenderer)
+    m_mapViewport {
+        sdlRenderer, m_mapRenderer, MapScale(s_displayX), MapScale(s_displayY), wadFile.m_palette, wadFile.m_colorMap.get(), false},
+    m_sdlRenderer(sdlRenderer), m_isRecording {false}
 { }
 
 constexpr int GameLoop::ViewScale(int windowSize) const
@@ -23,21 +25,24 @@ constexpr int GameLoop::MapScale(int windowSize) const
     return static_cast<int>(windowSize * 0.25f);
 }
 
-void GameLoop::Move(int moveDirection)
+void GameLoop::Move(int moveDirection, InputLatency::Clock::time_point inputTime)
 {
     m_moveDirection = moveDirection;
+    m_inputLatency.Input(inputTime);
 }
 
-void GameLoop::Rotate(int rotateDirection)
+void GameLoop::Rotate(int rotateDirection, InputLatency::Clock::time_point inputTime)
 {
     m_rotateDirection = rotateDirection;
+    m_inputLatency.Input(inputTime);
 }
 
-const Frame* GameLoop::RenderFrame()
+const FrameStats* GameLoop::RenderFrame()
 {
     if(m_renderingMode == Renderer::RenderingMode::OpenGL)
     {
         m_glViewport.Draw();
+        m_inputLatency.Present(InputLatency::Clock::now());
         return NULL;
     }
     else
@@ -53,17 +58,14 @@ const Frame* GameLoop::RenderFrame()
             m_mapViewport.Draw();
         }
         SDL_RenderPresent(m_sdlRenderer);
-        return m_softwareRenderer.GetLastFrame();
+        m_inputLatency.Present(InputLatency::Clock::now());
+        return &m_softwareRenderer.GetFrameStats();
     }
 }
 
 void GameLoop::ClipPlayer()
 {
-    const auto& sector = m_gameState.m_mapDef->GetSector(Point(m_gameState.m_player.x, m_gameState.m_player.y));
-    if(sector.has_value())
-    {
-        m_gameState.m_player.z = sector.value().floorHeight + 45;
-    }
+    m_gameState.ClipPlayer();
 }
 
 void GameLoop::StepFrame()
@@ -73,8 +75,13 @@ void GameLoop::StepFrame()
 
 void GameLoop::Tick(float seconds)
 {
+    if(m_isRecording)
+    {
+        m_demo.RecordMove(m_moveDirection, m_rotateDirection, seconds);
+    }
     m_gameState.Move(m_moveDirection, m_rotateDirection, seconds);
     ClipPlayer();
+    m_inputLatency.Tick(InputLatency::Clock::now());
 }
 
 void GameLoop::ResizeWindow(int width, int height)
@@ -93,9 +100,32 @@ void GameLoop::SetRenderingMode(Renderer::RenderingMode renderingMode)
     }
 }
 
+// switch the player view between the given frame buffer and the direct 32-bit one
+Viewport::FrameBufferType GameLoop::ToggleFrameBuffer(Viewport::FrameBufferType frameBufferType)
+{
+    const auto isActive = m_playerViewport.GetFrameBufferType() == frameBufferType;
+    m_playerViewport.SetFrameBufferType(isActive ? Viewport::FrameBufferType::Direct : frameBufferType);
+    return m_playerViewport.GetFrameBufferType();
+}
+
+// start capturing player inputs to be replayed by the timedemo
+void GameLoop::StartRecording(const std::string& mapName)
+{
+    m_demo.Clear();
+    m_demo.m_mapName = mapName;
+    m_demo.RecordPose(m_gameState.m_player);
+    m_isRecording = true;
+}
+
+void GameLoop::StopRecording(const std::string& fileName)
+{
+    m_isRecording = false;
+    m_demo.Save(fileName);
+}
+
 void GameLoop::Start(const MapStore& mapStore)
 {
-    m_gameState.NewGame(mapStore);
+    m_gameState.NewGame(mapStore, m_wadFile);
     ClipPlayer();
     m_isRunning = true;
     m_glViewport.Reset();
@@ -10,12 +10,15 @@
 #include "GLRenderer.h"
 #include "GLViewport.h"
 #include "MapRenderer.h"
+#include "Demo.h"
+#include "InputLatency.h"
 
 namespace rtdoom
 {
 class GameLoop
 {
 protected:
+    const WADFile&          m_wadFile;
     GameState               m_gameState;
     SoftwareRenderer        m_softwareRenderer;
     GLRenderer              m_glRenderer;
@@ -29,6 +32,9 @@ protected:
     int                     m_rotateDirection;
     Renderer::RenderingMode m_renderingMode;
     SDL_Renderer*           m_sdlRenderer;
+    Demo                    m_demo;
+    bool                    m_isRecording;
+    InputLatency            m_inputLatency;
 
     constexpr int ViewScale(int windowSize) const;
     constexpr int MapScale(int windowSize) const;
@@ -41,15 +47,28 @@ public:
         return m_isRunning;
     }
 
-    void Move(int moveDirection);
-    void Rotate(int rotateDirection);
+    void Move(int moveDirection, InputLatency::Clock::time_point inputTime);
+    void Rotate(int rotateDirection, InputLatency::Clock::time_point inputTime);
 
-    const Frame* RenderFrame();
-    void         ClipPlayer();
-    void         StepFrame();
-    void         Tick(float seconds);
-    void         ResizeWindow(int width, int height);
-    void         SetRenderingMode(Renderer::RenderingMode renderingMode);
+    const FrameStats* RenderFrame();
+    void              ClipPlayer();
+    void              StepFrame();
+    void              Tick(float seconds);
+    void              ResizeWindow(int width, int height);
+    void              SetRenderingMode(Renderer::RenderingMode renderingMode);
+    void              StartRecording(const std::string& mapName);
+    void              StopRecording(const std::string& fileName);
+    bool              isRecording() const
+    {
+        return m_isRecording;
+    }
+
+    Viewport::FrameBufferType ToggleFrameBuffer(Viewport::FrameBufferType frameBufferType);
+
+    const InputLatency& GetInputLatency() const
+    {
+        return m_inputLatency;
+    }
 
     const Thing& Player() const
     {
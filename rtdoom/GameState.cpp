@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "rtdoom.h"
 #include "GameState.h"
-#include "Projection.h"
+#include "MathCache.h"
 
 using std::string;
 
@@ -9,9 +9,9 @@ namespace rtdoom
 {
 GameState::GameState() : m_player {0, 0, 0, 0}, m_mapDef {nullptr}, m_step {0} {}
 
-void GameState::NewGame(const MapStore& mapStore)
+void GameState::NewGame(const MapStore& mapStore, const WADFile& wadFile)
 {
-    m_mapDef = std::make_unique<MapDef>(mapStore);
+    m_mapDef = std::make_unique<MapDef>(mapStore, wadFile);
     m_player = m_mapDef->GetStartingPosition();
     m_step   = 0;
 }
@@ -20,11 +20,21 @@ void GameState::Move(int m, int r, float step)
 {
     m_step += step;
 
-    m_player.a += step * 16 * -0.15f * r;
-    m_player.x += step * 32 * 10.0f * m * cos(m_player.a);
-    m_player.y += step * 32 * 10.0f * m * sin(m_player.a);
+    // turning wraps around in binary angles, the player keeps radians for the rest of the engine
+    const auto angle = ToBinaryAngle(m_player.a) + ToBinaryAngle(step * 16 * -0.15f * r);
+    m_player.x += step * 32 * 10.0f * m * MathCache::instance().Cos(angle);
+    m_player.y += step * 32 * 10.0f * m * MathCache::instance().Sin(angle);
+    m_player.a = ToRadians(angle);
+}
 
-    m_player.a = Projection::NormalizeAngle(m_player.a);
+// keep the player's eyes above the floor of the sector they're in
+void GameState::ClipPlayer()
+{
+    const auto& sector = m_mapDef->GetSector(Point(m_player.x, m_player.y));
+    if(sector.has_value())
+    {
+        m_player.z = sector.value().floorHeight + 45;
+    }
 }
 
 GameState::~GameState() {}
@@ -12,7 +12,8 @@ public:
     Thing                   m_player;
 
     void Move(int m, int r, float step);
-    void NewGame(const MapStore& mapStore);
+    void ClipPlayer();
+    void NewGame(const MapStore& mapStore, const WADFile& wadFile);
 
     GameState();
     ~GameState();
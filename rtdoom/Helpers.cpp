@@ -40,6 +40,35 @@ float Helpers::Clip(float v, float max)
     return v;
 }
 
+std::vector<std::string> Helpers::Split(const std::string& list, char separator)
+{
+    std::vector<std::string> items;
+    std::istringstream       input(list);
+    std::string              item;
+    while(std::getline(input, item, separator))
+    {
+        if(!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::optional<std::string> Helpers::FindWAD()
+{
+    for(const auto& entry : std::filesystem::directory_iterator("."))
+    {
+        auto extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+        if(entry.is_regular_file() && extension == ".wad")
+        {
+            return entry.path().generic_string();
+        }
+    }
+    return std::nullopt;
+}
+
 Helpers::Helpers() {}
 
 Helpers::~Helpers() {}
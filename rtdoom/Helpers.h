@@ -48,6 +48,12 @@ public:
     static int   Clip(int v, int max);
     static float Clip(float v, float max);
 
+    // non-empty items of a separated list, e.g. --maps E1M1,E1M2
+    static std::vector<std::string> Split(const std::string& list, char separator);
+
+    // first .wad file in the current directory
+    static std::optional<std::string> FindWAD();
+
     Helpers();
     ~Helpers();
 };
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "InputLatency.h"
+
+#include <numeric>
+
+namespace rtdoom
+{
+InputLatency::InputLatency() {}
+
+void InputLatency::Input(Clock::time_point inputTime)
+{
+    m_pendingEvents.push_back(Event {inputTime, inputTime, 0});
+}
+
+void InputLatency::Tick(Clock::time_point tickTime)
+{
+    for(auto& event : m_pendingEvents)
+    {
+        event.tickTime = tickTime;
+        m_appliedEvents.push_back(event);
+    }
+    m_pendingEvents.clear();
+}
+
+// frames rendered before the tick still count towards the delay of pending inputs
+void InputLatency::Present(Clock::time_point presentTime)
+{
+    for(auto& event : m_pendingEvents)
+    {
+        event.numFrames++;
+    }
+    for(const auto& event : m_appliedEvents)
+    {
+        m_samples.push_back(Sample {std::chrono::duration<double, std::milli>(event.tickTime - event.inputTime).count(),
+                                    std::chrono::duration<double, std::milli>(presentTime - event.inputTime).count(),
+                                    event.numFrames + 1});
+    }
+    m_appliedEvents.clear();
+}
+
+std::ostream& operator<<(std::ostream& os, const InputLatency& inputLatency)
+{
+    const auto& samples = inputLatency.Samples();
+    if(samples.empty())
+    {
+        return os << "no inputs measured";
+    }
+
+    std::vector<double> latencies;
+    double              toTick = 0;
+    std::map<int, int>  frameCounts;
+    for(const auto& sample : samples)
+    {
+        latencies.push_back(sample.toPresent);
+        toTick += sample.toTick;
+        frameCounts[sample.numFrames]++;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    // nearest-rank percentiles
+    const auto percentile = [&latencies](double p) {
+        const auto rank = static_cast<size_t>(std::ceil(p * latencies.size()));
+        return latencies[std::clamp(rank, static_cast<size_t>(1), latencies.size()) - 1];
+    };
+    const auto average = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+
+    os << samples.size() << " inputs, min " << latencies.front() << "ms, avg " << average << "ms (" << toTick / samples.size()
+       << "ms to tick), p50 " << percentile(0.5) << "ms, p95 " << percentile(0.95) << "ms, p99 " << percentile(0.99) << "ms, max "
+       << latencies.back() << "ms, presented after";
+    for(const auto& [numFrames, count] : frameCounts)
+    {
+        os << (numFrames == frameCounts.begin()->first ? " " : ", ") << numFrames << (numFrames == 1 ? " frame x" : " frames x") << count;
+    }
+    return os;
+}
+
+InputLatency::~InputLatency() {}
+} // namespace rtdoom
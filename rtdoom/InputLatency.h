@@ -0,0 +1,46 @@
+#pragma once
+
+namespace rtdoom
+{
+// follows input events from the moment they're received, through the game tick that applies them,
+// until the first frame showing their effect is presented
+class InputLatency
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample
+    {
+        double toTick;    // ms from the input to the tick applying it
+        double toPresent; // ms from the input to the present showing it
+        int    numFrames; // frames presented in between, including the one showing it
+    };
+
+    void Input(Clock::time_point inputTime);
+    void Tick(Clock::time_point tickTime);
+    void Present(Clock::time_point presentTime);
+
+    const std::vector<Sample>& Samples() const
+    {
+        return m_samples;
+    }
+
+    InputLatency();
+    ~InputLatency();
+
+protected:
+    struct Event
+    {
+        Clock::time_point inputTime;
+        Clock::time_point tickTime;
+        int               numFrames;
+    };
+
+    // received but not applied yet, applied but not presented yet
+    std::vector<Event>  m_pendingEvents;
+    std::vector<Event>  m_appliedEvents;
+    std::vector<Sample> m_samples;
+};
+
+std::ostream& operator<<(std::ostream& os, const InputLatency& inputLatency);
+} // namespace rtdoom
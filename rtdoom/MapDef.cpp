@@ -10,12 +10,12 @@ using std::shared_ptr;
 
 namespace rtdoom
 {
-MapDef::MapDef(const MapStore& mapStore) : m_store {mapStore}
+MapDef::MapDef(const MapStore& mapStore, const WADFile& wadFile) : m_store {mapStore}, m_wadFile {wadFile}
 {
     Initialize();
 }
 
-MapDef::MapDef(const string& mapFolder)
+MapDef::MapDef(const string& mapFolder, const WADFile& wadFile) : m_wadFile {wadFile}
 {
     m_store.Load(mapFolder);
     Initialize();
@@ -25,8 +25,8 @@ void MapDef::Initialize()
 {
     OpenDoors();
     BuildWireframe();
-    BuildSegments();
     BuildSectors();
+    BuildSegments();
     BuildSubSectors();
     BuildThings();
 }
@@ -51,20 +51,6 @@ void MapDef::OpenDoors()
 }
 
 // traverse the BSP tree stored with the map depth-first
-deque<shared_ptr<Segment>> MapDef::GetSegmentsToDraw(const Point& pov) const
-{
-    deque<shared_ptr<Segment>> segments;
-    const auto&                subSectors = GetSubSectorsToDraw(pov);
-    for(auto& subSector : subSectors)
-    {
-        for(auto& segment : subSector->segments)
-        {
-            segments.push_back(segment);
-        }
-    }
-    return segments;
-}
-
 deque<shared_ptr<SubSector>> MapDef::GetSubSectorsToDraw(const Point& pov) const
 {
     deque<shared_ptr<SubSector>> subSectors;
@@ -218,34 +204,34 @@ void MapDef::ProcessSegment(float sx, float sy, float ex, float ey, unsigned sho
         if(direction == 1 && lineDef.leftSideDef < 32000)
         {
             frontSide   = m_store.m_sideDefs[lineDef.leftSideDef];
-            frontSector = Sector {frontSide.sector, m_store.m_sectors[frontSide.sector]};
+            frontSector = m_sectors[frontSide.sector];
             if(lineDef.rightSideDef < 32000)
             {
                 backSide   = m_store.m_sideDefs[lineDef.rightSideDef];
-                backSector = Sector {backSide.sector, m_store.m_sectors[backSide.sector]};
+                backSector = m_sectors[backSide.sector];
             }
         }
         else if(direction == 0 && lineDef.rightSideDef < 32000)
         {
             frontSide   = m_store.m_sideDefs[lineDef.rightSideDef];
-            frontSector = Sector {frontSide.sector, m_store.m_sectors[frontSide.sector]};
+            frontSector = m_sectors[frontSide.sector];
             if(lineDef.leftSideDef < 32000)
             {
                 backSide   = m_store.m_sideDefs[lineDef.leftSideDef];
-                backSector = Sector {backSide.sector, m_store.m_sectors[backSide.sector]};
+                backSector = m_sectors[backSide.sector];
             }
         }
 
         Side front {frontSector,
-                    Helpers::MakeString(frontSide.lowerTexture),
-                    Helpers::MakeString(frontSide.middleTexture),
-                    Helpers::MakeString(frontSide.upperTexture),
+                    LookupTexture(frontSide.lowerTexture),
+                    LookupTexture(frontSide.middleTexture),
+                    LookupTexture(frontSide.upperTexture),
                     frontSide.xOffset,
                     frontSide.yOffset};
         Side back {backSector,
-                   Helpers::MakeString(backSide.lowerTexture),
-                   Helpers::MakeString(backSide.middleTexture),
-                   Helpers::MakeString(backSide.upperTexture),
+                   LookupTexture(backSide.lowerTexture),
+                   LookupTexture(backSide.middleTexture),
+                   LookupTexture(backSide.upperTexture),
                    frontSide.xOffset,
                    frontSide.yOffset};
 
@@ -256,6 +242,7 @@ void MapDef::ProcessSegment(float sx, float sy, float ex, float ey, unsigned sho
     {
         m_segments.push_back(std::make_shared<Segment>(s, e, false, Side(), Side(), offset, false, false));
     }
+    m_segments.back()->segmentId = static_cast<int>(m_segments.size()) - 1;
 }
 
 void MapDef::LookupVertex(unsigned short vertexNo, float& x, float& y)
@@ -274,6 +261,12 @@ void MapDef::LookupVertex(unsigned short vertexNo, float& x, float& y)
     }
 }
 
+// texture names are only resolved here, renderers work with ids
+int MapDef::LookupTexture(const char name[8]) const
+{
+    return m_wadFile.TextureId(Helpers::MakeString(name));
+}
+
 void MapDef::BuildSegments()
 {
     if(m_store.m_glSegments.size())
@@ -325,7 +318,7 @@ void MapDef::BuildSectors()
     int s = 0;
     for(const auto& sector : m_store.m_sectors)
     {
-        m_sectors.emplace_back(Sector(s++, sector));
+        m_sectors.emplace_back(Sector(s++, sector, LookupTexture(sector.ceilingTexture), LookupTexture(sector.floorTexture)));
     }
 }
 
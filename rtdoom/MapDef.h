@@ -5,15 +5,19 @@
 
 namespace rtdoom
 {
+class WADFile;
+
 class MapDef
 {
 protected:
-    MapStore m_store;
+    MapStore       m_store;
+    const WADFile& m_wadFile;
 
     static bool IsInFrontOf(const Point& pov, const MapStore::Node& node) noexcept;
     static bool IsInFrontOf(const Point& pov, const Vertex& sv, const Vertex& ev) noexcept;
 
     void LookupVertex(unsigned short vertexNo, float& x, float& y);
+    int  LookupTexture(const char name[8]) const;
     void ProcessSegment(float sx, float sy, float ex, float ey, unsigned short lineDefNo, signed short direction, signed short offset);
     void ProcessNode(const Point& pov, const MapStore::Node& node, std::deque<std::shared_ptr<SubSector>>& subSectors) const;
     void ProcessChildRef(unsigned short childRef, const Point& pov, std::deque<std::shared_ptr<SubSector>>& subSectors) const;
@@ -37,11 +41,10 @@ public:
 
     Thing                                  GetStartingPosition() const;
     std::optional<Sector>                  GetSector(const Point& pov) const;
-    std::deque<std::shared_ptr<Segment>>   GetSegmentsToDraw(const Point& pov) const;
     std::deque<std::shared_ptr<SubSector>> GetSubSectorsToDraw(const Point& pov) const;
 
-    MapDef(const std::string& mapFolder);
-    MapDef(const MapStore& mapStore);
+    MapDef(const std::string& mapFolder, const WADFile& wadFile);
+    MapDef(const MapStore& mapStore, const WADFile& wadFile);
     ~MapDef();
 };
 } // namespace rtdoom
@@ -63,42 +63,37 @@ struct Sector
 {
     Sector() : sectorId {-1} {}
 
-    Sector(int sectorId, const MapStore::Sector& s) :
+    Sector(int sectorId, const MapStore::Sector& s, int ceilingTextureId, int floorTextureId) :
         sectorId {sectorId}, floorHeight {static_cast<float>(s.floorHeight)}, ceilingHeight {static_cast<float>(s.ceilingHeight)},
-        ceilingTexture {Helpers::MakeString(s.ceilingTexture)}, floorTexture {Helpers::MakeString(s.floorTexture)},
-        lightLevel {s.lightLevel / 255.0f}, isSky {strcmp(s.ceilingTexture, "F_SKY1") == 0}
+        ceilingTextureId {ceilingTextureId}, floorTextureId {floorTextureId}, lightLevel {s.lightLevel / 255.0f},
+        isSky {strcmp(s.ceilingTexture, "F_SKY1") == 0}
     {}
 
-    int         sectorId;
-    std::string ceilingTexture;
-    std::string floorTexture;
-    float       floorHeight;
-    float       ceilingHeight;
-    float       lightLevel;
-    bool        isSky;
+    int   sectorId;
+    int   ceilingTextureId = s_noTexture;
+    int   floorTextureId   = s_noTexture;
+    float floorHeight;
+    float ceilingHeight;
+    float lightLevel;
+    bool  isSky;
 };
 
 struct Side
 {
-    Side(Sector            sector,
-         const std::string lowerTexture,
-         const std::string middleTexture,
-         const std::string upperTexture,
-         int               xOffset,
-         int               yOffset) :
-        sideless(false), sector {sector},
-        lowerTexture {lowerTexture}, middleTexture {middleTexture}, upperTexture {upperTexture}, xOffset {xOffset}, yOffset {yOffset}
+    Side(Sector sector, int lowerTextureId, int middleTextureId, int upperTextureId, int xOffset, int yOffset) :
+        sideless(false), sector {sector}, lowerTextureId {lowerTextureId}, middleTextureId {middleTextureId},
+        upperTextureId {upperTextureId}, xOffset {xOffset}, yOffset {yOffset}
     {}
 
     Side() : sideless(true) { }
 
-    bool        sideless;
-    Sector      sector;
-    int         xOffset;
-    int         yOffset;
-    std::string lowerTexture;
-    std::string upperTexture;
-    std::string middleTexture;
+    bool   sideless;
+    Sector sector;
+    int    xOffset;
+    int    yOffset;
+    int    lowerTextureId  = s_noTexture;
+    int    upperTextureId  = s_noTexture;
+    int    middleTextureId = s_noTexture;
 };
 
 struct Segment : Line
@@ -118,6 +113,7 @@ struct Segment : Line
 
     bool isHorizontal = s.y == e.y;
     bool isVertical   = s.x == e.x;
+    int  segmentId    = -1;
 };
 
 struct SubSector
@@ -3,86 +3,114 @@
 
 namespace rtdoom
 {
-MathCache::MathCache()
+namespace
 {
-    for(size_t i = 0; i <= s_precision; i++)
-    {
-        _tan[i]  = tanf(i * PI4 / s_precision);
-        _atan[i] = atanf(i * PI4 / s_precision);
-        _cos[i]  = cosf(i * 2.0f * PI / s_precision);
-        _sin[i]  = sinf(i * 2.0f * PI / s_precision);
-    }
-}
+constexpr double s_pi      = 3.14159265358979323846;
+constexpr size_t s_quarter = MathCache::s_fineAngles / 4;
+constexpr size_t s_eighth  = MathCache::s_fineAngles / 8;
 
-int MathCache::sign(float v) const
+// Taylor series, well within float precision up to a quarter turn
+constexpr double TaylorSine(double x)
 {
-    return v < 0 ? 1 : 0;
+    auto term = x;
+    auto sum  = x;
+    for(int n = 1; n < 12; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
 }
 
-float MathCache::FastArcTan(float x) const
+// Euler's series, terms shrink at least by half for 0 <= x <= 1
+constexpr double EulerArcTangent(double x)
 {
-    return PI4 * x - x * (x - 1) * (0.2447f + 0.0663f * x);
+    const auto y    = x * x / (1 + x * x);
+    auto       term = x / (1 + x * x);
+    auto       sum  = term;
+    for(int n = 1; n < 40; n++)
+    {
+        term *= y * (2 * n) / (2 * n + 1);
+        sum += term;
+    }
+    return sum;
 }
 
-float MathCache::_atan2f(float y, float x) const
+// sines of fine angles over five quarter turns, so that cosines are the same table a quarter turn ahead
+constexpr std::array<float, MathCache::s_fineAngles * 5 / 4> MakeSines()
 {
-    if(x == 1.0f)
+    std::array<float, MathCache::s_fineAngles * 5 / 4> sines {};
+    for(size_t i = 0; i <= s_quarter; i++)
     {
-        return atanf(y);
+        sines[i] = static_cast<float>(TaylorSine(i * 2 * s_pi / MathCache::s_fineAngles));
     }
-
-    uint32_t m = 2 * sign(x) + sign(y);
-    if(y == 0)
+    for(size_t i = s_quarter + 1; i < sines.size(); i++)
     {
-        switch(m)
+        if(i <= 2 * s_quarter)
         {
-        case 0:
-        case 1:
-            return y; /* atan(+-0,+anything)=+-0 */
-        case 2:
-            return PI; /* atan(+0,-anything) = pi */
-        case 3:
-            return -PI; /* atan(-0,-anything) =-pi */
+            sines[i] = sines[2 * s_quarter - i];
+        }
+        else if(i < 4 * s_quarter)
+        {
+            sines[i] = -sines[i - 2 * s_quarter];
+        }
+        else
+        {
+            sines[i] = sines[i - 4 * s_quarter];
         }
     }
+    return sines;
+}
 
-    if(x == 0)
-    {
-        return m & 1 ? -PI2 : PI2;
-    }
+constexpr auto s_sines = MakeSines();
 
-    float z;
-    auto  v = fabsf(y / x);
-    if(v < 1)
-    {
-        z = FastArcTan(v);
-    }
-    else
+// tangents of fine angles from -90 to 90 degrees, -90 itself is clamped to its neighbour
+constexpr std::array<float, MathCache::s_fineAngles / 2> MakeTangents()
+{
+    std::array<float, MathCache::s_fineAngles / 2> tangents {};
+    for(size_t i = 1; i < tangents.size(); i++)
     {
-        z = atanf(v);
+        const auto angle = (i + 3 * s_quarter) % MathCache::s_fineAngles;
+        tangents[i]      = s_sines[angle] / s_sines[angle + s_quarter];
     }
-    switch(m)
+    tangents[0] = tangents[1];
+    return tangents;
+}
+
+constexpr auto s_tangents = MakeTangents();
+
+// binary angles of arc tangents of 0..1 in s_eighth steps, which covers the first octant
+constexpr std::array<BinaryAngle, s_eighth + 1> MakeArcTangents()
+{
+    std::array<BinaryAngle, s_eighth + 1> arcTangents {};
+    for(size_t i = 0; i < arcTangents.size(); i++)
     {
-    case 0:
-        return z; /* atan(+,+) */
-    case 1:
-        return -z; /* atan(-,+) */
-    case 2:
-        return PI - z; /* atan(+,-) */
-    default:
-        return z - PI; /* atan(-,-) */
+        const auto radians = EulerArcTangent(static_cast<double>(i) / s_eighth);
+        arcTangents[i]     = static_cast<BinaryAngle>(radians / (2 * s_pi) * 4294967296.0 + 0.5);
     }
+    return arcTangents;
 }
 
+constexpr auto s_arcTangents = MakeArcTangents();
+
+// 0 <= ratio <= 1
+BinaryAngle OctantArcTan(float ratio) noexcept
+{
+    return s_arcTangents[static_cast<size_t>(ratio * s_eighth + 0.5f)];
+}
+} // namespace
+
+MathCache::MathCache() {}
+
 float MathCache::ArcTan(float x) const
 {
     if constexpr(!s_useCache)
     {
         return atanf(x);
     }
-    auto v = static_cast<size_t>(fabsf(x) / PI4 * s_precision);
-    auto s = x < 0 ? -1 : 1;
-    return _atan[v % (s_precision + 1)] * s;
+    const auto v     = fabsf(x);
+    const auto angle = v <= 1 ? OctantArcTan(v) : s_angle90 - OctantArcTan(1 / v);
+    return ToRadians(x < 0 ? 0 - angle : angle);
 }
 
 float MathCache::ArcTan(float dy, float dx) const
@@ -91,7 +119,7 @@ float MathCache::ArcTan(float dy, float dx) const
     {
         return atan2f(dy, dx);
     }
-    return _atan2f(dy, dx);
+    return ToRadians(Direction(dy, dx));
 }
 
 float MathCache::Cos(float x) const
@@ -100,12 +128,7 @@ float MathCache::Cos(float x) const
     {
         return cosf(x);
     }
-    while(x < 2 * PI)
-    {
-        x += 2 * PI;
-    }
-    auto v = static_cast<size_t>(x / (2 * PI) * s_precision);
-    return _cos[v % (s_precision + 1)];
+    return Cos(ToBinaryAngle(x));
 }
 
 float MathCache::Sin(float x) const
@@ -114,12 +137,7 @@ float MathCache::Sin(float x) const
     {
         return sinf(x);
     }
-    while(x < 2 * PI)
-    {
-        x += 2 * PI;
-    }
-    auto v = static_cast<size_t>(x / (2 * PI) * s_precision);
-    return _sin[v % (s_precision + 1)];
+    return Sin(ToBinaryAngle(x));
 }
 
 float MathCache::Tan(float x) const
@@ -128,9 +146,56 @@ float MathCache::Tan(float x) const
     {
         return tanf(x);
     }
-    auto v = static_cast<size_t>(fabsf(x) / PI4 * s_precision);
-    auto s = x < 0 ? -1 : 1;
-    return _tan[v % (s_precision + 1)] * s;
+    return Tan(ToBinaryAngle(x));
+}
+
+float MathCache::Cos(BinaryAngle angle) const noexcept
+{
+    if constexpr(!s_useCache)
+    {
+        return cosf(ToRadians(angle));
+    }
+    return s_sines[(angle >> s_fineShift) + s_quarter];
+}
+
+float MathCache::Sin(BinaryAngle angle) const noexcept
+{
+    if constexpr(!s_useCache)
+    {
+        return sinf(ToRadians(angle));
+    }
+    return s_sines[angle >> s_fineShift];
+}
+
+float MathCache::Tan(BinaryAngle angle) const noexcept
+{
+    if constexpr(!s_useCache)
+    {
+        return tanf(ToRadians(angle));
+    }
+    return s_tangents[(angle + s_angle90) >> s_fineShift & (s_tangents.size() - 1)];
+}
+
+// the octant is found from the signs and magnitudes of the coordinates, the angle within it from the table
+BinaryAngle MathCache::Direction(float dy, float dx) const noexcept
+{
+    if constexpr(!s_useCache)
+    {
+        return ToBinaryAngle(atan2f(dy, dx));
+    }
+    const auto ax = fabsf(dx);
+    const auto ay = fabsf(dy);
+    if(ax == 0 && ay == 0)
+    {
+        return 0;
+    }
+
+    auto angle = ay <= ax ? OctantArcTan(ay / ax) : s_angle90 - OctantArcTan(ax / ay);
+    if(dx < 0)
+    {
+        angle = s_angle180 - angle;
+    }
+    return dy < 0 ? 0 - angle : angle;
 }
 
 const MathCache& MathCache::instance()
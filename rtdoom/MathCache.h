@@ -4,25 +4,21 @@
 
 namespace rtdoom
 {
-// singleton with precalculated trigonometric functions
+// singleton with trigonometric tables over binary angles, generated at compile time
 class MathCache
 {
 protected:
     MathCache();
 
-    constexpr static bool   s_useCache  = true;
-    constexpr static size_t s_precision = 16384;
-
-    int   sign(float v) const;
-    float FastArcTan(float x) const;
-    float _atan2f(float y, float x) const;
+public:
+    // table resolution in binary angles, 1 << s_fineBits steps per full turn
+    constexpr static int    s_fineBits   = 14;
+    constexpr static size_t s_fineAngles = size_t {1} << s_fineBits;
+    constexpr static int    s_fineShift  = 32 - s_fineBits;
 
-    std::array<float, s_precision + 1> _tan;
-    std::array<float, s_precision + 1> _atan;
-    std::array<float, s_precision + 1> _cos;
-    std::array<float, s_precision + 1> _sin;
+    // when disabled all functions fall through to libm
+    constexpr static bool s_useCache = true;
 
-public:
     static const MathCache& instance();
 
     float ArcTan(float x) const;
@@ -30,5 +26,13 @@ public:
     float Cos(float x) const;
     float Sin(float x) const;
     float Tan(float x) const;
+
+    // table lookups without branches, Tan between -90 and 90 degrees
+    float Cos(BinaryAngle angle) const noexcept;
+    float Sin(BinaryAngle angle) const noexcept;
+    float Tan(BinaryAngle angle) const noexcept;
+
+    // angle of the vector (dx, dy), as atan2(dy, dx)
+    BinaryAngle Direction(float dy, float dx) const noexcept;
 };
 } // namespace rtdoom
@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "OverdrawFrameBuffer.h"
+
+namespace rtdoom
+{
+OverdrawFrameBuffer::OverdrawFrameBuffer(int width, int height, const Palette& palette) :
+    FrameBuffer {width, height, palette}, m_counts(static_cast<size_t>(width) * height)
+{}
+
+// counts are kept internally, there are no pixels to attach
+void OverdrawFrameBuffer::Attach(void* /*pixels*/, std::function<void()> stepCallback)
+{
+    m_stepCallback = stepCallback;
+}
+
+void OverdrawFrameBuffer::Clear()
+{
+    std::fill(m_counts.begin(), m_counts.end(), static_cast<uint16_t>(0));
+}
+
+void OverdrawFrameBuffer::VerticalLine(int x, int sy, int ey, int /*colorIndex*/, float /*lightness*/) noexcept
+{
+    if(x >= 0 && x < m_width)
+    {
+        sy = std::max(0, std::min(sy, m_height - 1));
+        ey = std::max(0, std::min(ey, m_height - 1));
+        if(sy > ey)
+        {
+            std::swap(sy, ey);
+        }
+        for(auto y = sy; y <= ey; y++)
+        {
+            Count(x, y);
+        }
+    }
+}
+
+void OverdrawFrameBuffer::VerticalLine(int x, int sy, const std::vector<int>& texels, float /*lightness*/) noexcept
+{
+    if(x >= 0 && x < m_width)
+    {
+        for(const auto t : texels)
+        {
+            if(sy >= m_height)
+            {
+                break;
+            }
+            // transparent texels are not written
+            if(t != 247 && sy >= 0)
+            {
+                Count(x, sy);
+            }
+            sy++;
+        }
+    }
+}
+
+void OverdrawFrameBuffer::VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& /*lightnesses*/) noexcept
+{
+    if(x >= 0 && x < m_width)
+    {
+        const auto ey = std::min(m_height - 1, sy + static_cast<int>(texels.size()) - 1);
+        for(auto y = std::max(0, sy); y <= ey; y++)
+        {
+            Count(x, y);
+        }
+    }
+}
+
+void OverdrawFrameBuffer::HorizontalLine(int sx, int y, const std::vector<int>& texels, float /*lightness*/) noexcept
+{
+    if(y >= 0 && y < m_height)
+    {
+        const auto ex = std::min(m_width - 1, sx + static_cast<int>(texels.size()) - 1);
+        for(auto x = std::max(0, sx); x <= ex; x++)
+        {
+            Count(x, y);
+        }
+    }
+}
+
+void OverdrawFrameBuffer::HorizontalLine(int sx, int ex, int y, int /*colorIndex*/, float /*lightness*/) noexcept
+{
+    if(y >= 0 && y < m_height && sx >= 0 && ex < m_width)
+    {
+        for(auto x = sx; x <= ex; x++)
+        {
+            Count(x, y);
+        }
+    }
+}
+
+void OverdrawFrameBuffer::SetPixel(int x, int y, int /*colorIndex*/, float /*lightness*/) noexcept
+{
+    if(x >= 0 && y >= 0 && x < m_width && y < m_height)
+    {
+        Count(x, y);
+    }
+}
+
+void OverdrawFrameBuffer::SetColor(int x, int y, uint32_t /*argb*/) noexcept
+{
+    SetPixel(x, y, 0, 0);
+}
+
+OverdrawFrameBuffer::Stats OverdrawFrameBuffer::Resolve(FrameBuffer& frameBuffer) const
+{
+    Stats stats;
+    for(auto y = 0; y < m_height; y++)
+    {
+        for(auto x = 0; x < m_width; x++)
+        {
+            const int count = m_counts[y * m_width + x];
+            frameBuffer.SetColor(x, y, s_heatColors[std::min(count, static_cast<int>(s_heatColors.size()) - 1)]);
+
+            stats.numWrites += count;
+            stats.numCoveredPixels += count > 0;
+            stats.numOverdrawnPixels += count > 1;
+            stats.maxWrites = std::max(stats.maxWrites, count);
+        }
+    }
+    return stats;
+}
+
+OverdrawFrameBuffer::~OverdrawFrameBuffer() {}
+} // namespace rtdoom
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+namespace rtdoom
+{
+// frame buffer counting how many times each pixel is written instead of storing colors,
+// resolved into a heatmap on another frame buffer
+class OverdrawFrameBuffer : public FrameBuffer
+{
+protected:
+    std::vector<uint16_t> m_counts;
+
+    // black (never drawn), blue (drawn once), then green, yellow, orange, red and white for increasing overdraw
+    const std::array<uint32_t, 7> s_heatColors {0x00000000, 0x00202080, 0x0000a000, 0x00e0e000, 0x00ff8000, 0x00ff0000, 0x00ffffff};
+
+    void Count(int x, int y) noexcept
+    {
+        m_counts[y * m_width + x]++;
+        m_numPixels++;
+    }
+
+public:
+    struct Stats
+    {
+        size_t numWrites          = 0; // pixel writes in total
+        size_t numCoveredPixels   = 0; // pixels written at least once
+        size_t numOverdrawnPixels = 0; // pixels written more than once
+        int    maxWrites          = 0;
+    };
+
+    virtual void Attach(void* pixels, std::function<void()> stepCallback) override;
+    virtual void Clear() override;
+    virtual void SetPixel(int x, int y, int color, float lightness) noexcept override;
+    virtual void SetColor(int x, int y, uint32_t argb) noexcept override;
+    virtual void VerticalLine(int x, int sy, int ey, int colorIndex, float lightness) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, const std::vector<float>& lightnesses) noexcept override;
+    virtual void VerticalLine(int x, int sy, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void HorizontalLine(int sx, int y, const std::vector<int>& texels, float lightness) noexcept override;
+    virtual void HorizontalLine(int sx, int ex, int y, int colorIndex, float lightness) noexcept override;
+
+    // paint the heatmap onto frameBuffer and return the totals
+    Stats Resolve(FrameBuffer& frameBuffer) const;
+
+    OverdrawFrameBuffer(int width, int height, const Palette& palette);
+    ~OverdrawFrameBuffer();
+};
+} // namespace rtdoom
@@ -5,5 +5,37 @@ namespace rtdoom
 {
 Painter::Painter(FrameBuffer& frameBuffer) : m_frameBuffer(frameBuffer) {}
 
+void Painter::QueueWall(WallColumns& walls, int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const
+{
+    if(walls.numColumns == WallColumns::s_maxColumns || (walls.numColumns > 0 && x != walls.x + walls.numColumns))
+    {
+        FlushWalls(walls);
+    }
+    if(walls.numColumns == 0)
+    {
+        walls.x = x;
+    }
+    walls.spans[walls.numColumns]    = span;
+    walls.contexts[walls.numColumns] = textureContext;
+    walls.numColumns++;
+}
+
+void Painter::FlushWalls(WallColumns& walls) const
+{
+    if(walls.numColumns > 0)
+    {
+        PaintWalls(walls);
+        walls.numColumns = 0;
+    }
+}
+
+void Painter::PaintWalls(const WallColumns& walls) const
+{
+    for(auto i = 0; i < walls.numColumns; i++)
+    {
+        PaintWall(walls.x + i, walls.spans[i], walls.contexts[i]);
+    }
+}
+
 Painter::~Painter() {}
 } // namespace rtdoom
@@ -12,10 +12,31 @@ protected:
     FrameBuffer& m_frameBuffer;
 
 public:
+    // adjacent columns of one wall section, collected so that they can be painted row by row
+    struct WallColumns
+    {
+        static constexpr int s_maxColumns = 4;
+
+        int                                             x          = 0;
+        int                                             numColumns = 0;
+        std::array<Frame::Span, s_maxColumns>           spans;
+        std::array<Frame::PainterContext, s_maxColumns> contexts;
+    };
+
+    // number of texels read from textures and sprites
+    mutable size_t m_numTexels = 0;
+
     virtual void PaintWall(int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const               = 0;
     virtual void PaintSprite(int x, int sy, std::vector<bool> occlusion, const Frame::PainterContext& textureContext) const = 0;
     virtual void PaintPlane(const Frame::Plane& plane) const                                                                = 0;
 
+    // paints columns queued so far when x does not continue them or there are already s_maxColumns, then queues x
+    void QueueWall(WallColumns& walls, int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const;
+    void FlushWalls(WallColumns& walls) const;
+
+    // by default the columns are painted one at a time
+    virtual void PaintWalls(const WallColumns& walls) const;
+
     Painter(FrameBuffer& frameBuffer);
     virtual ~Painter();
 };
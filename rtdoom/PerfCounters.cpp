@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rtdoom
+{
+const char* PerfCounters::CounterName(Counter counter)
+{
+    switch(counter)
+    {
+    case Counter::Cycles:
+        return "cycles";
+    case Counter::Instructions:
+        return "instructions";
+    case Counter::L1DMisses:
+        return "l1d_misses";
+    case Counter::LLCMisses:
+        return "llc_misses";
+    case Counter::BranchMisses:
+        return "branch_misses";
+    default:
+        return "unknown";
+    }
+}
+
+PerfCounters::Values PerfCounters::Values::operator-(const Values& rhs) const
+{
+    Values result;
+    for(size_t c = 0; c < s_numCounters; c++)
+    {
+        result.counts[c] = counts[c] - rhs.counts[c];
+    }
+    return result;
+}
+
+PerfCounters::Values& PerfCounters::Values::operator+=(const Values& rhs)
+{
+    for(size_t c = 0; c < s_numCounters; c++)
+    {
+        counts[c] += rhs.counts[c];
+    }
+    return *this;
+}
+
+double PerfCounters::Values::IPC() const
+{
+    const auto cycles = (*this)[Counter::Cycles];
+    return cycles ? static_cast<double>((*this)[Counter::Instructions]) / cycles : 0;
+}
+
+double PerfCounters::Values::MPKI(Counter counter) const
+{
+    const auto instructions = (*this)[Counter::Instructions];
+    return instructions ? 1000.0 * (*this)[counter] / instructions : 0;
+}
+
+PerfCounters::PerfCounters() : m_groupFd {-1}
+{
+    m_fds.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+    Close();
+}
+
+#ifdef __linux__
+bool PerfCounters::Open()
+{
+    Close();
+
+    const std::array<std::pair<uint32_t, uint64_t>, s_numCounters> events {
+        {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+         {PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+         {PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}}};
+
+    // open all counters as a single group so they are scheduled together and read with one call,
+    // skipping the ones the CPU (or hypervisor) does not support
+    for(size_t c = 0; c < s_numCounters; c++)
+    {
+        perf_event_attr attr {};
+        attr.size           = sizeof(attr);
+        attr.type           = events[c].first;
+        attr.config         = events[c].second;
+        attr.disabled       = m_groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP;
+
+        const auto fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, m_groupFd, 0));
+        if(fd < 0)
+        {
+            continue;
+        }
+        if(m_groupFd < 0)
+        {
+            m_groupFd = fd;
+        }
+        m_fds[c] = fd;
+        m_groupOrder.push_back(static_cast<Counter>(c));
+    }
+
+    if(m_groupFd < 0)
+    {
+        return false;
+    }
+    ioctl(m_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::Close()
+{
+    for(auto& fd : m_fds)
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    m_groupFd = -1;
+    m_groupOrder.clear();
+}
+
+PerfCounters::Values PerfCounters::Read() const
+{
+    Values values;
+    if(m_groupFd < 0)
+    {
+        return values;
+    }
+
+    // PERF_FORMAT_GROUP layout: number of counters followed by their values
+    std::array<uint64_t, s_numCounters + 1> buffer {};
+    if(read(m_groupFd, buffer.data(), sizeof(buffer)) > 0)
+    {
+        for(size_t i = 0; i < std::min<size_t>(buffer[0], m_groupOrder.size()); i++)
+        {
+            values.counts[static_cast<size_t>(m_groupOrder[i])] = buffer[i + 1];
+        }
+    }
+    return values;
+}
+#else
+bool PerfCounters::Open()
+{
+    return false;
+}
+
+void PerfCounters::Close() {}
+
+PerfCounters::Values PerfCounters::Read() const
+{
+    return Values();
+}
+#endif
+} // namespace rtdoom
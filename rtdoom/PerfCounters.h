@@ -0,0 +1,63 @@
+#pragma once
+
+namespace rtdoom
+{
+// hardware performance counters of the calling thread, read through perf_event_open (Linux only)
+class PerfCounters
+{
+public:
+    enum class Counter
+    {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses
+    };
+    static constexpr size_t s_numCounters = 5;
+
+    static const char* CounterName(Counter counter);
+
+    // event counts, zero for counters that could not be opened
+    struct Values
+    {
+        std::array<uint64_t, s_numCounters> counts {};
+
+        uint64_t operator[](Counter counter) const
+        {
+            return counts[static_cast<size_t>(counter)];
+        }
+        Values  operator-(const Values& rhs) const;
+        Values& operator+=(const Values& rhs);
+
+        // instructions per cycle
+        double IPC() const;
+        // misses per thousand instructions
+        double MPKI(Counter counter) const;
+    };
+
+    // opens the counters, returns false if none are supported (non-Linux, perf_event_paranoid, virtualised PMU)
+    bool   Open();
+    void   Close();
+    Values Read() const;
+    bool   isOpen() const
+    {
+        return m_groupFd >= 0;
+    }
+    bool isAvailable(Counter counter) const
+    {
+        return m_fds[static_cast<size_t>(counter)] >= 0;
+    }
+
+    PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+protected:
+    int                            m_groupFd;
+    std::array<int, s_numCounters> m_fds;
+    // counters in the order they were added to the group, which is the order the kernel reports them in
+    std::vector<Counter> m_groupOrder;
+};
+} // namespace rtdoom
@@ -5,37 +5,65 @@
 
 namespace rtdoom
 {
+ProjectionTables::ProjectionTables(int width, int height) :
+    width {width}, height {height}, viewAngles(width), rowDistances(height), rowLightFalloffs(height)
+{
+    const auto midPointX = width / 2;
+    for(auto x = 0; x < width; x++)
+    {
+        const auto fractionX = static_cast<float>(x - midPointX) / midPointX;
+        viewAngles[x]        = MathCache::instance().ArcTan(fractionX * PI4);
+    }
+
+    // the middle row looks at the horizon
+    const auto midPointY = height / 2;
+    for(auto y = 0; y < height; y++)
+    {
+        rowDistances[y]     = (height * 30.0f) / static_cast<float>(abs(y - midPointY));
+        rowLightFalloffs[y] = rowDistances[y] / (23.0f * s_lightnessFactor);
+    }
+}
+
 Projection::Projection(const Thing& player, const FrameBuffer& frameBuffer) :
-    m_player {player}, m_viewWidth {frameBuffer.m_width}, m_midPointX {frameBuffer.m_width / 2}, m_viewHeight {frameBuffer.m_height},
-    m_midPointY {frameBuffer.m_height / 2}
+    Projection {player, frameBuffer, std::make_shared<ProjectionTables>(frameBuffer.m_width, frameBuffer.m_height)}
 {}
 
+Projection::Projection(const Thing& player, const FrameBuffer& frameBuffer, std::shared_ptr<const ProjectionTables> tables) :
+    m_player {player}, m_viewWidth {frameBuffer.m_width}, m_midPointX {frameBuffer.m_width / 2}, m_viewHeight {frameBuffer.m_height},
+    m_midPointY {frameBuffer.m_height / 2}, m_tables {std::move(tables)}
+{
+    if(m_tables->width != m_viewWidth || m_tables->height != m_viewHeight)
+    {
+        throw std::runtime_error("Projection tables do not match the frame buffer");
+    }
+}
+
 // normal vector from a map line towards the player
 Vector Projection::NormalVector(const Line& l) const
 {
     auto lineAngle =
-        MathCache::instance().ArcTan(l.e.y - l.s.y, l.e.x - l.s.x); // 0 is towards positive X axis, clockwise, (0,0) is top-left
-    auto normalAngle    = lineAngle + PI2;
+        MathCache::instance().Direction(l.e.y - l.s.y, l.e.x - l.s.x); // 0 is towards positive X axis, clockwise, (0,0) is top-left
+    auto normalAngle    = lineAngle + s_angle90;
     auto sx             = l.s.x - m_player.x;
     auto sy             = l.s.y - m_player.y;
     auto startDistance  = Projection::Distance(l.s, m_player);
-    auto startAngle     = MathCache::instance().ArcTan(sy, sx);
+    auto startAngle     = MathCache::instance().Direction(sy, sx);
     auto normalDistance = startDistance * MathCache::instance().Cos(normalAngle - startAngle);
-    return Vector(normalAngle, abs(normalDistance));
+    return Vector(ToRadians(normalAngle), abs(normalDistance));
 }
 
 // distance the starting edge of the line to its normal vector start
 float Projection::NormalOffset(const Line& l) const
 {
     auto lineAngle =
-        MathCache::instance().ArcTan(l.e.y - l.s.y, l.e.x - l.s.x); // 0 is towards positive X axis, clockwise, (0,0) is top-left
-    auto normalAngle   = lineAngle + PI2;
+        MathCache::instance().Direction(l.e.y - l.s.y, l.e.x - l.s.x); // 0 is towards positive X axis, clockwise, (0,0) is top-left
+    auto normalAngle   = lineAngle + s_angle90;
     auto sx            = l.s.x - m_player.x;
     auto sy            = l.s.y - m_player.y;
     auto startDistance = Projection::Distance(l.s, m_player);
-    auto startAngle    = MathCache::instance().ArcTan(sy, sx);
+    auto startAngle    = MathCache::instance().Direction(sy, sx);
     auto normalOffset  = fabs(startDistance * MathCache::instance().Sin(normalAngle - startAngle));
-    if(NormalizeAngle(normalAngle - startAngle) > 0)
+    if(static_cast<int32_t>(normalAngle - startAngle) > 0)
     {
         normalOffset *= -1;
     }
@@ -45,7 +73,7 @@ float Projection::NormalOffset(const Line& l) const
 // absolute angle to a map point
 Angle Projection::AbsoluteAngle(const Point& p) const
 {
-    return MathCache::instance().ArcTan(p.y - m_player.y, p.x - m_player.x);
+    return ToRadians(MathCache::instance().Direction(p.y - m_player.y, p.x - m_player.x));
 }
 
 // relative projected view a for a map point
@@ -57,10 +85,13 @@ Angle Projection::ProjectionAngle(const Point& p) const
 // projection d from player to the line specified by the normal vector at specific viewAngle
 float Projection::Distance(const Vector& normalVector, Angle viewAngle) const
 {
-    auto inverseNormalAngle = normalVector.a - PI;
-    auto viewRelativeAngle  = NormalizeAngle(inverseNormalAngle - (m_player.a + viewAngle));
-    auto interceptDistance  = normalVector.d / MathCache::instance().Cos(viewRelativeAngle);
-    return abs(MathCache::instance().Cos(viewAngle) * interceptDistance);
+    if constexpr(s_useFixedPoint)
+    {
+        return DistanceFixed(normalVector, viewAngle).ToFloat();
+    }
+    auto viewRelativeAngle = ViewRelativeAngle(normalVector, viewAngle);
+    auto interceptDistance = normalVector.d / MathCache::instance().Cos(viewRelativeAngle);
+    return abs(MathCache::instance().Cos(ToBinaryAngle(viewAngle)) * interceptDistance);
 }
 
 // simple distance between two points
@@ -74,11 +105,14 @@ float Projection::Distance(const Point& a, const Point& b)
 // texture offset vs normal intercept
 float Projection::Offset(const Vector& normalVector, Angle viewAngle) const
 {
-    auto inverseNormalAngle = normalVector.a - PI;
-    auto viewRelativeAngle  = NormalizeAngle(inverseNormalAngle - (m_player.a + viewAngle));
-    auto interceptDistance  = normalVector.d / MathCache::instance().Cos(viewRelativeAngle);
-    auto offset             = fabsf(interceptDistance * MathCache::instance().Sin(viewRelativeAngle));
-    if(viewRelativeAngle > 0)
+    if constexpr(s_useFixedPoint)
+    {
+        return OffsetFixed(normalVector, viewAngle).ToFloat();
+    }
+    auto viewRelativeAngle = ViewRelativeAngle(normalVector, viewAngle);
+    auto interceptDistance = normalVector.d / MathCache::instance().Cos(viewRelativeAngle);
+    auto offset            = fabsf(interceptDistance * MathCache::instance().Sin(viewRelativeAngle));
+    if(static_cast<int32_t>(viewRelativeAngle) > 0)
     {
         offset *= -1;
     }
@@ -87,8 +121,21 @@ float Projection::Offset(const Vector& normalVector, Angle viewAngle) const
 
 float Projection::PlaneDistance(int y, float height) const noexcept
 {
-    auto dy = abs(y - m_midPointY);
-    return (m_viewHeight * 30.0f) * fabsf(height / 23.0f) / static_cast<float>(dy);
+    if constexpr(s_useFixedPoint)
+    {
+        return PlaneDistanceFixed(y, Fixed::FromFloat(height)).ToFloat();
+    }
+    return m_tables->rowDistances[y] * fabsf(height / 23.0f);
+}
+
+// Lightness at PlaneDistance, without the division
+float Projection::PlaneLightness(int y, float height) const noexcept
+{
+    if constexpr(s_useFixedPoint)
+    {
+        return Lightness(PlaneDistance(y, height));
+    }
+    return 0.9f - m_tables->rowLightFalloffs[y] * fabsf(height);
 }
 
 Angle Projection::AngleDist(Angle a1, Angle a2) noexcept
@@ -96,33 +143,33 @@ Angle Projection::AngleDist(Angle a1, Angle a2) noexcept
     return abs(NormalizeAngle(a2) - NormalizeAngle(a1));
 }
 
-// normalize a to -PI..PI
+// normalize a to -PI..PI, the binary angle wraps any number of turns
 Angle Projection::NormalizeAngle(Angle angle) noexcept
 {
-    while(angle < -PI)
-    {
-        angle += 2 * PI;
-    }
-    while(angle > PI)
-    {
-        angle -= 2 * PI;
-    }
-    return angle;
+    return ToRadians(ToBinaryAngle(angle));
+}
+
+// angle between the view ray and the inverse of the normal vector
+BinaryAngle Projection::ViewRelativeAngle(const Vector& normalVector, Angle viewAngle) const noexcept
+{
+    return ToBinaryAngle(normalVector.a) - s_angle180 - ToBinaryAngle(m_player.a) - ToBinaryAngle(viewAngle);
 }
 
 // convert eye a (-PI4..PI4) view to screen X coordinate
 int Projection::ViewX(Angle viewAngle) const noexcept
 {
-    viewAngle = NormalizeAngle(viewAngle);
-    if(viewAngle <= -PI4)
+    constexpr int32_t s_edge = s_angle45;
+
+    const auto angle = ToBinaryAngle(viewAngle);
+    if(static_cast<int32_t>(angle) <= -s_edge)
     {
         return -1;
     }
-    if(viewAngle >= PI4)
+    if(static_cast<int32_t>(angle) >= s_edge)
     {
         return m_viewWidth;
     }
-    auto midDistance = MathCache::instance().Tan(viewAngle) / PI4;
+    auto midDistance = MathCache::instance().Tan(angle) / PI4;
     if(midDistance <= -1)
     {
         return -1;
@@ -137,6 +184,10 @@ int Projection::ViewX(Angle viewAngle) const noexcept
 // convert screen X coordinate to eye a (-PI4..PI4)
 Angle Projection::ViewAngle(int viewX) const noexcept
 {
+    if(viewX >= 0 && viewX < m_viewWidth)
+    {
+        return m_tables->viewAngles[viewX];
+    }
     auto relativeX = (viewX - m_midPointX);
     auto fractionX = static_cast<float>(relativeX) / m_midPointX;
     return MathCache::instance().ArcTan(fractionX * PI4);
@@ -145,6 +196,10 @@ Angle Projection::ViewAngle(int viewX) const noexcept
 // vertical screen position for given distance and height difference
 int Projection::ViewY(float distance, float height) const noexcept
 {
+    if constexpr(s_useFixedPoint)
+    {
+        return ViewYFixed(Fixed::FromFloat(distance), Fixed::FromFloat(height));
+    }
     auto dc = (m_viewHeight * 30.0f) / distance;
     auto hf = fabsf(height / 23.0f);
     auto dy = static_cast<int>(dc * hf);
@@ -158,6 +213,10 @@ int Projection::ViewY(float distance, float height) const noexcept
 // scaling factor for texturing
 float Projection::TextureScale(float distance) const noexcept
 {
+    if constexpr(s_useFixedPoint)
+    {
+        return TextureScaleFixed(Fixed::FromFloat(distance)).ToFloat();
+    }
     return distance / (m_viewHeight * 1.30434782f);
 }
 
@@ -218,5 +277,101 @@ float Projection::Lightness(float distance, const Segment* segment) const
     return lightness;
 }
 
+// column screenX of the wall, ready to step to the right; the tangent of a column's view angle is linear in screen x,
+// and since this runs once per span the wall's angle goes through libm rather than the tables
+Projection::WallColumn Projection::StepWall(const Vector& normalVector, int screenX) const noexcept
+{
+    if(normalVector.d <= 0)
+    {
+        return {INFINITY, 0, 0, 0};
+    }
+    const auto inverseNormal = ToRadians(ViewRelativeAngle(normalVector, 0));
+    const auto cosNormal     = cosf(inverseNormal);
+    const auto sinNormal     = sinf(inverseNormal);
+    const auto tangentStep   = PI4 / m_midPointX;
+    const auto tangent       = (screenX - m_midPointX) * tangentStep;
+
+    // the normal's angle follows the line's direction and not the player's side, so this cosine is negative for half of the walls,
+    // 1/distance is kept positive so that the offset comes out with the sign of Offset(normalVector, viewAngle)
+    const auto cosRelative = cosNormal + tangent * sinNormal;
+    const auto sign        = cosRelative < 0 ? -1.0f : 1.0f;
+    return {sign * cosRelative / normalVector.d,
+            tangent * cosNormal - sinNormal,
+            sign * tangentStep * sinNormal / normalVector.d,
+            tangentStep * cosNormal};
+}
+
+// a single column projected from its view angle, for segment edges and fixed point builds
+Projection::WallColumn Projection::ProjectWall(const Vector& normalVector, Angle viewAngle) const
+{
+    const auto inverseDistance = 1 / Distance(normalVector, viewAngle);
+    return {inverseDistance, Offset(normalVector, viewAngle) * inverseDistance, 0, 0};
+}
+
+// same as ViewY but multiplying by the stepped 1/distance
+int Projection::ViewY(const WallColumn& column, float height) const noexcept
+{
+    if constexpr(s_useFixedPoint)
+    {
+        return ViewYFixed(Fixed::FromFloat(column.Distance()), Fixed::FromFloat(height));
+    }
+    auto dy = static_cast<int>((m_viewHeight * 30.0f / 23.0f) * fabsf(height) * fabsf(column.inverseDistance));
+    if(height > 0)
+    {
+        return m_midPointY - dy;
+    }
+    return m_midPointY + dy;
+}
+
+// the float constants 30 / 23 and 1.30434782 above are the same ratio, kept as integers here
+int Projection::ViewYFixed(Fixed distance, Fixed height) const noexcept
+{
+    constexpr int64_t s_maxDy = 1 << 24;
+
+    const auto numerator   = static_cast<int64_t>(m_viewHeight) * 30 * height.Abs().raw;
+    const auto denominator = static_cast<int64_t>(distance.raw) * 23;
+    const auto dy          = static_cast<int>(denominator > 0 ? std::min(s_maxDy, numerator / denominator) : s_maxDy);
+    if(height > Fixed {0})
+    {
+        return m_midPointY - dy;
+    }
+    return m_midPointY + dy;
+}
+
+Fixed Projection::TextureScaleFixed(Fixed distance) const noexcept
+{
+    return Fixed::FromRaw(static_cast<int64_t>(distance.raw) * 23 / (m_viewHeight * 30));
+}
+
+Fixed Projection::PlaneDistanceFixed(int y, Fixed height) const noexcept
+{
+    const auto dy = abs(y - m_midPointY);
+    return Fixed::FromRaw(dy ? static_cast<int64_t>(m_viewHeight) * 30 * height.Abs().raw / (23 * dy) : INT32_MAX);
+}
+
+// ratios of trigonometric functions are taken at 2.30 precision, 16.16 would lose too much of a small cosine
+Fixed Projection::DistanceFixed(const Vector& normalVector, Angle viewAngle) const
+{
+    constexpr float s_trigOne = 1 << 30;
+
+    const auto viewRelativeAngle = ViewRelativeAngle(normalVector, viewAngle);
+    const auto cosView           = static_cast<int64_t>(MathCache::instance().Cos(ToBinaryAngle(viewAngle)) * s_trigOne);
+    const auto cosRelative       = static_cast<int64_t>(MathCache::instance().Cos(viewRelativeAngle) * s_trigOne);
+    const auto normalDistance    = Fixed::FromFloat(normalVector.d).raw;
+    return Fixed::FromRaw(cosRelative ? normalDistance * cosView / cosRelative : INT32_MAX).Abs();
+}
+
+Fixed Projection::OffsetFixed(const Vector& normalVector, Angle viewAngle) const
+{
+    constexpr float s_trigOne = 1 << 30;
+
+    const auto viewRelativeAngle = ViewRelativeAngle(normalVector, viewAngle);
+    const auto sinRelative       = static_cast<int64_t>(MathCache::instance().Sin(viewRelativeAngle) * s_trigOne);
+    const auto cosRelative       = static_cast<int64_t>(MathCache::instance().Cos(viewRelativeAngle) * s_trigOne);
+    const auto normalDistance    = Fixed::FromFloat(normalVector.d).raw;
+    const auto offset            = Fixed::FromRaw(cosRelative ? normalDistance * sinRelative / cosRelative : INT32_MAX).Abs();
+    return static_cast<int32_t>(viewRelativeAngle) > 0 ? Fixed {0} - offset : offset;
+}
+
 Projection::~Projection() {}
 } // namespace rtdoom
@@ -2,9 +2,23 @@
 
 #include "MapDef.h"
 #include "FrameBuffer.h"
+#include "Fixed.h"
 
 namespace rtdoom
 {
+// parts of the projection that only depend on the resolution, built once and shared by all frames drawn at it,
+// the row tables round differently from dividing per row, which changes a few pixels of textured flats in some frames
+struct ProjectionTables
+{
+    const int          width;
+    const int          height;
+    std::vector<Angle> viewAngles; // view angle of each column
+    std::vector<float> rowDistances; // plane distance of each row at a height of 23
+    std::vector<float> rowLightFalloffs; // lightness lost per unit of height at each row's plane distance
+
+    ProjectionTables(int width, int height);
+};
+
 class Projection
 {
 protected:
@@ -14,7 +28,39 @@ protected:
     const int    m_midPointX;
     const int    m_midPointY;
 
+    std::shared_ptr<const ProjectionTables> m_tables;
+
+    BinaryAngle ViewRelativeAngle(const Vector& normalVector, Angle viewAngle) const noexcept;
+
 public:
+    // when enabled ViewY, TextureScale, PlaneDistance, Distance, Offset and the texture steppers run in 16.16 fixed point,
+    // see the *Fixed variants for how far they are from the float results
+    constexpr static bool s_useFixedPoint = false;
+
+    // a flat wall seen through one screen column, 1/distance and offset/distance are linear in screen x,
+    // so the next column is one step away instead of an arc tangent, three trigonometric lookups and two divisions
+    struct WallColumn
+    {
+        float inverseDistance;
+        float offsetRatio;
+        float inverseDistanceStep;
+        float offsetRatioStep;
+
+        void Step() noexcept
+        {
+            inverseDistance += inverseDistanceStep;
+            offsetRatio += offsetRatioStep;
+        }
+        float Distance() const noexcept
+        {
+            return 1 / fabsf(inverseDistance);
+        }
+        float Offset() const noexcept
+        {
+            return offsetRatio / inverseDistance;
+        }
+    };
+
     static Angle AngleDist(Angle a1, Angle a2) noexcept;
     static Angle NormalizeAngle(Angle angle) noexcept;
     static bool  NormalizeViewAngleSpan(Angle& a1, Angle& a2) noexcept;
@@ -29,11 +75,30 @@ public:
     float  Distance(const Vector& normalVector, Angle viewAngle) const;
     float  Offset(const Vector& normalVector, Angle viewAngle) const;
     float  PlaneDistance(int y, float height) const noexcept;
+    float  PlaneLightness(int y, float height) const noexcept;
     Angle  AbsoluteAngle(const Point& p) const;
     Angle  ProjectionAngle(const Point& p) const;
     float  Lightness(float distance, const Segment* segment = nullptr) const;
 
+    // against view rays intersected with walls further than 32 and seen at more than 5 degrees, kernelbench measures StepWall
+    // within 6e-3 in relative Distance and 2.7 texels in texture offset at 640 columns, ProjectWall within 1e-2 and 4.9 texels,
+    // mostly from NormalVector's table lookups which both share; the two are within 1 pixel in ViewY of each other and,
+    // when seen at more than 30 degrees, within a texel of each other
+    WallColumn StepWall(const Vector& normalVector, int screenX) const noexcept;
+    WallColumn ProjectWall(const Vector& normalVector, Angle viewAngle) const;
+    int        ViewY(const WallColumn& column, float height) const noexcept;
+
+    // differences from the float functions as measured by kernelbench, distances saturate at 32767:
+    // ViewY 1 pixel, TextureScale 2^-16, PlaneDistance 2^-16 relative, Distance 2^-14 relative and Offset 2^-10 texels
+    // for walls further than s_minDistance seen at more than 5 degrees
+    int   ViewYFixed(Fixed distance, Fixed height) const noexcept;
+    Fixed TextureScaleFixed(Fixed distance) const noexcept;
+    Fixed PlaneDistanceFixed(int y, Fixed height) const noexcept;
+    Fixed DistanceFixed(const Vector& normalVector, Angle viewAngle) const;
+    Fixed OffsetFixed(const Vector& normalVector, Angle viewAngle) const;
+
     Projection(const Thing& player, const FrameBuffer& frameBuffer);
+    Projection(const Thing& player, const FrameBuffer& frameBuffer, std::shared_ptr<const ProjectionTables> tables);
     ~Projection();
 };
 } // namespace rtdoom
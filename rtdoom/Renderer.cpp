@@ -3,8 +3,37 @@
 
 namespace rtdoom
 {
+const std::map<std::string, Renderer::RenderingMode> s_modeNames {{"wireframe", Renderer::RenderingMode::Wireframe},
+                                                                  {"solid", Renderer::RenderingMode::Solid},
+                                                                  {"textured", Renderer::RenderingMode::Textured},
+                                                                  {"overdraw", Renderer::RenderingMode::Overdraw}};
+
 Renderer::Renderer(const GameState& gameState) : RendererBase(gameState) {}
 
+void Renderer::Resize(int /*width*/, int /*height*/) {}
+
+std::optional<Renderer::RenderingMode> Renderer::ParseMode(const std::string& name)
+{
+    const auto mode = s_modeNames.find(name);
+    if(mode == s_modeNames.end())
+    {
+        return std::nullopt;
+    }
+    return mode->second;
+}
+
+std::string Renderer::ModeName(RenderingMode mode)
+{
+    for(const auto& [name, value] : s_modeNames)
+    {
+        if(value == mode)
+        {
+            return name;
+        }
+    }
+    return "unknown";
+}
+
 bool Renderer::IsVisible(int x, int y, FrameBuffer& frameBuffer)
 {
     return (x >= 0 && y >= 0 && x < frameBuffer.m_width && y < frameBuffer.m_height);
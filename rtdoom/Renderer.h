@@ -16,6 +16,7 @@ public:
         Wireframe,
         Solid,
         Textured,
+        Overdraw,
         OpenGL
     };
 
@@ -33,6 +34,13 @@ protected:
 public:
     virtual void RenderFrame(FrameBuffer& frameBuffer) = 0;
 
+    // the frame buffers passed to RenderFrame will have a new size from now on
+    virtual void Resize(int width, int height);
+
+    // command line names of the software rendering modes
+    static std::optional<RenderingMode> ParseMode(const std::string& name);
+    static std::string                  ModeName(RenderingMode mode);
+
     Renderer(const GameState& gameState);
     virtual ~Renderer();
 };
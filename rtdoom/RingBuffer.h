@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+
+namespace rtdoom
+{
+// lock-free queue for exactly one producer and one consumer thread, capacity has to be a power of two
+template <typename T, size_t N>
+class RingBuffer
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity has to be a power of two");
+
+protected:
+    std::array<T, N> m_items;
+
+    // running indices, wrapped into m_items with a mask; each is written by one side only
+    alignas(64) std::atomic<size_t> m_head {0}; // next item to write, owned by the producer
+    alignas(64) std::atomic<size_t> m_tail {0}; // next item to read, owned by the consumer
+
+public:
+    // producer only, returns false when the buffer is full
+    bool TryPush(const T& item)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if(head - m_tail.load(std::memory_order_acquire) == N)
+        {
+            return false;
+        }
+        m_items[head & (N - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, returns false when the buffer is empty
+    bool TryPop(T& item)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if(m_head.load(std::memory_order_acquire) == tail)
+        {
+            return false;
+        }
+        item = m_items[tail & (N - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+};
+} // namespace rtdoom
@@ -5,36 +5,92 @@
 #include "WireframePainter.h"
 #include "SolidPainter.h"
 #include "TexturePainter.h"
+#include "Tracer.h"
 
 namespace rtdoom
 {
 SoftwareRenderer::SoftwareRenderer(const GameState& gameState, const WADFile& wadFile) :
-    Renderer {gameState}, m_wadFile {wadFile}, m_renderingMode {RenderingMode::Textured}
+    Renderer {gameState}, m_wadFile {wadFile}, m_renderingMode {RenderingMode::Textured}, m_perfCounters {nullptr},
+    m_mipmaps {true}, m_tiledFlats {true}
 {}
 
+// time a single phase of rendering the frame
+template <typename F>
+void SoftwareRenderer::RunPhase(FrameStats::Phase phase, F&& renderPhase)
+{
+    TraceScope trace(FrameStats::PhaseName(phase), "phase");
+    const auto startCounters    = m_perfCounters ? m_perfCounters->Read() : PerfCounters::Values();
+    const auto startAllocations = AllocationCounter::Read();
+    const auto startTime        = std::chrono::steady_clock::now();
+
+    renderPhase();
+
+    const auto phaseTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    m_frameStats.phaseTimes[static_cast<size_t>(phase)] = phaseTime;
+    m_frameStats.frameTime += phaseTime;
+
+    const auto phaseAllocations = AllocationCounter::Read() - startAllocations;
+    m_frameStats.phaseAllocations[static_cast<size_t>(phase)] = phaseAllocations;
+    m_frameStats.frameAllocations += phaseAllocations;
+
+    if(m_perfCounters)
+    {
+        const auto phaseCounters = m_perfCounters->Read() - startCounters;
+        m_frameStats.phaseCounters[static_cast<size_t>(phase)] = phaseCounters;
+        m_frameStats.frameCounters += phaseCounters;
+    }
+}
+
 // entry method for rendering a frame
 void SoftwareRenderer::RenderFrame(FrameBuffer& frameBuffer)
 {
-    Initialize(frameBuffer);
+    TraceScope trace("frame", "frame");
+    const auto numPixels = frameBuffer.m_numPixels;
+    m_frameStats         = FrameStats();
+
+    RunPhase(FrameStats::Phase::Initialize, [&]() { Initialize(frameBuffer); });
 
     // walls
-    RenderSegments();
+    RunPhase(FrameStats::Phase::Segments, [&]() { RenderSegments(); });
 
     // floors and ceilings
-    RenderPlanes();
+    RunPhase(FrameStats::Phase::Planes, [&]() { RenderPlanes(); });
 
     // things/objects
-    RenderSprites();
+    RunPhase(FrameStats::Phase::Sprites, [&]() { RenderSprites(); });
 
     // HUD
-    RenderOverlay();
+    RunPhase(FrameStats::Phase::Overlay, [&]() {
+        RenderOverlay();
+        if(m_renderingMode == RenderingMode::Overdraw)
+        {
+            RenderOverdraw(frameBuffer);
+        }
+    });
+
+    m_frameStats.numSegments      = m_frame->m_numSegments;
+    m_frameStats.numFloorPlanes   = m_frame->m_numFloorPlanes;
+    m_frameStats.numCeilingPlanes = m_frame->m_numCeilingPlanes;
+    m_frameStats.numSprites       = static_cast<int>(m_frame->m_sprites.size());
+    m_frameStats.numVisplanes     = m_frame->m_numVisplanes;
+    m_frameStats.numClips         = m_frame->m_numClips;
+    m_frameStats.numSubSectors    = m_frame->m_numSubSectors;
+    m_frameStats.numPixels        = frameBuffer.m_numPixels - numPixels;
+    m_frameStats.numTexels        = m_painter->m_numTexels;
 }
 
 void SoftwareRenderer::Initialize(FrameBuffer& frameBuffer)
 {
     m_frameBuffer = &frameBuffer;
-    m_projection  = std::make_unique<Projection>(m_gameState.m_player, frameBuffer);
-    m_frame       = std::make_unique<Frame>(frameBuffer);
+
+    // the size is checked as well since frame buffers can change without a Resize, like timedemo's resolutions do
+    if(!m_projectionTables || m_projectionTables->width != frameBuffer.m_width || m_projectionTables->height != frameBuffer.m_height)
+    {
+        m_projectionTables = std::make_shared<ProjectionTables>(frameBuffer.m_width, frameBuffer.m_height);
+        m_textureCache     = std::make_shared<TexturePainter::Cache>();
+    }
+    m_projection = std::make_unique<Projection>(m_gameState.m_player, frameBuffer, m_projectionTables);
+    m_frame      = std::make_unique<Frame>(frameBuffer);
     switch(m_renderingMode)
     {
     case RenderingMode::Wireframe:
@@ -44,7 +100,18 @@ void SoftwareRenderer::Initialize(FrameBuffer& frameBuffer)
         m_painter = std::make_unique<SolidPainter>(frameBuffer, *m_projection);
         break;
     case RenderingMode::Textured:
-        m_painter = std::make_unique<TexturePainter>(frameBuffer, m_gameState.m_player, *m_projection, m_wadFile);
+        m_painter = std::make_unique<TexturePainter>(
+            frameBuffer, m_gameState.m_player, *m_projection, m_wadFile, m_mipmaps, m_tiledFlats, m_textureCache);
+        break;
+    case RenderingMode::Overdraw:
+        // textured rendering with every pixel write counted
+        if(!m_overdrawBuffer || m_overdrawBuffer->m_width != frameBuffer.m_width || m_overdrawBuffer->m_height != frameBuffer.m_height)
+        {
+            m_overdrawBuffer = std::make_unique<OverdrawFrameBuffer>(frameBuffer.m_width, frameBuffer.m_height, frameBuffer.m_palette);
+        }
+        m_overdrawBuffer->Clear();
+        m_painter = std::make_unique<TexturePainter>(
+            *m_overdrawBuffer, m_gameState.m_player, *m_projection, m_wadFile, m_mipmaps, m_tiledFlats, m_textureCache);
         break;
     default:
         throw std::runtime_error("Unsupported rendering mode");
@@ -54,17 +121,21 @@ void SoftwareRenderer::Initialize(FrameBuffer& frameBuffer)
 void SoftwareRenderer::RenderSegments() const
 {
     // iterate through all segments (map lines) in visibility order returned by traversing the map's BSP tree
-    for(const auto& segment : m_gameState.m_mapDef->GetSegmentsToDraw(m_gameState.m_player))
+    for(const auto& subSector : m_gameState.m_mapDef->GetSubSectorsToDraw(m_gameState.m_player))
     {
-        // only draw segments that are facing the player
-        if(MapDef::IsInFrontOf(m_gameState.m_player, *segment))
+        m_frame->m_numSubSectors++;
+        for(const auto& segment : subSector->segments)
         {
-            RenderMapSegment(*segment);
-
-            // stop drawing once the frame has been fully occluded with solid walls or vertical spans
-            if(m_frame->IsOccluded())
+            // only draw segments that are facing the player
+            if(MapDef::IsInFrontOf(m_gameState.m_player, *segment))
             {
-                break;
+                RenderMapSegment(*segment);
+
+                // stop drawing once the frame has been fully occluded with solid walls or vertical spans
+                if(m_frame->IsOccluded())
+                {
+                    return;
+                }
             }
         }
     }
@@ -72,6 +143,9 @@ void SoftwareRenderer::RenderSegments() const
 
 void SoftwareRenderer::RenderMapSegment(const Segment& segment) const
 {
+    TraceScope trace("segment", "segments");
+    trace.Arg("id", segment.segmentId);
+
     if(segment.frontSide.sideless || segment.backSide.sideless)
     {
         return;
@@ -97,7 +171,7 @@ void SoftwareRenderer::RenderMapSegment(const Segment& segment) const
     }
 
     // clip the mapSegment against already drawn solid walls (horizontal occlusion)
-    const auto visibleSpans = m_frame->ClipHorizontalSegment(vs.startX, vs.endX, segment.isSolid);
+    const auto& visibleSpans = m_frame->ClipHorizontalSegment(vs.startX, vs.endX, segment.isSolid);
     if(visibleSpans.empty())
     {
         return;
@@ -123,12 +197,19 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
     const auto& frontSector = mapSegment.frontSide.sector;
     Frame::Clip lowerClip {span}, middleClip {span}, upperClip {span};
 
-    // iterate through all vertical columns from left to right
-    for(auto x = span.s; x <= span.e; x++)
+    // wall sections are painted a few adjacent columns at a time
+    Painter::WallColumns lowerWalls, middleWalls, upperWalls;
+
+    // iterate through all vertical columns from left to right, stepping the distance and texture offset between them
+    auto wall = m_projection->StepWall(visibleSegment.normalVector, span.s);
+    for(auto x = span.s; x <= span.e; x++, wall.Step())
     {
-        // calculate the relative viewAngle and distance to the mapSegment from our viewpoint
-        auto viewAngle = GetViewAngle(x, visibleSegment);
-        auto projectionDistance  = m_projection->Distance(visibleSegment.normalVector, viewAngle);
+        // columns on the edges of the mapSegment are projected from its exact view angles, like all columns in fixed point
+        const auto isEdge             = x == visibleSegment.startX || x == visibleSegment.endX;
+        const auto column             = isEdge || Projection::s_useFixedPoint
+                                            ? m_projection->ProjectWall(visibleSegment.normalVector, GetViewAngle(x, visibleSegment))
+                                            : wall;
+        const auto projectionDistance = column.Distance();
         if(projectionDistance < s_minDistance)
         {
             lowerClip.Add(x, Frame::PainterContext(), 0, 0);
@@ -138,18 +219,17 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
         }
 
         // calculate on-screen vertical start and end positions for the column, based on the front (outer) side
-        const auto outerTopY    = m_projection->ViewY(projectionDistance, frontSector.ceilingHeight - m_gameState.m_player.z);
-        const auto outerBottomY = m_projection->ViewY(projectionDistance, frontSector.floorHeight - m_gameState.m_player.z);
+        const auto outerTopY    = m_projection->ViewY(column, frontSector.ceilingHeight - m_gameState.m_player.z);
+        const auto outerBottomY = m_projection->ViewY(column, frontSector.floorHeight - m_gameState.m_player.z);
 
         Frame::PainterContext outerTexture;
-        outerTexture.yScale      = m_projection->TextureScale(projectionDistance);
-        outerTexture.yPegging    = mapSegment.lowerUnpegged ? outerBottomY : outerTopY;
-        outerTexture.textureName = mapSegment.frontSide.middleTexture;
-        outerTexture.yOffset     = mapSegment.frontSide.yOffset;
+        outerTexture.yScale    = m_projection->TextureScale(projectionDistance);
+        outerTexture.yPegging  = mapSegment.lowerUnpegged ? outerBottomY : outerTopY;
+        outerTexture.textureId = mapSegment.frontSide.middleTextureId;
+        outerTexture.yOffset   = mapSegment.frontSide.yOffset;
         // texel x position is the offset from player to normal vector plus offset from normal vector to view, plus static mapSegment and linedef offsets
-        outerTexture.texelX = visibleSegment.normalOffset + m_projection->Offset(visibleSegment.normalVector, viewAngle) +
-                              mapSegment.xOffset + mapSegment.frontSide.xOffset;
-        outerTexture.isEdge    = x == visibleSegment.startX || x == visibleSegment.endX;
+        outerTexture.texelX    = visibleSegment.normalOffset + column.Offset() + mapSegment.xOffset + mapSegment.frontSide.xOffset;
+        outerTexture.isEdge    = isEdge;
         outerTexture.lightness = m_projection->Lightness(projectionDistance, &mapSegment) * frontSector.lightLevel;
 
         // clip the column based on what we've already have drawn (vertical occlusion)
@@ -161,8 +241,8 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
                                                              mapSegment.isSolid,
                                                              &ceilingHeight,
                                                              &floorHeight,
-                                                             frontSector.ceilingTexture,
-                                                             frontSector.floorTexture,
+                                                             frontSector.ceilingTextureId,
+                                                             frontSector.floorTextureId,
                                                              frontSector.lightLevel);
 
         if(mapSegment.isSolid)
@@ -170,7 +250,7 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
             middleClip.Add(x, outerTexture, 0, m_frameBuffer->m_height - 1);
             if(outerSpan.isVisible())
             {
-                m_painter->PaintWall(x, outerSpan, outerTexture);
+                m_painter->QueueWall(middleWalls, x, outerSpan, outerTexture);
             }
         }
         else
@@ -179,8 +259,8 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
             const auto& backSector = mapSegment.backSide.sector;
 
             // recalculate column size for the back side
-            const auto innerTopY    = m_projection->ViewY(projectionDistance, backSector.ceilingHeight - m_gameState.m_player.z);
-            const auto innerBottomY = m_projection->ViewY(projectionDistance, backSector.floorHeight - m_gameState.m_player.z);
+            const auto innerTopY    = m_projection->ViewY(column, backSector.ceilingHeight - m_gameState.m_player.z);
+            const auto innerBottomY = m_projection->ViewY(column, backSector.floorHeight - m_gameState.m_player.z);
 
             // segments that connect open sky sectors should not have their top sections drawn
             const auto isSky = frontSector.isSky && backSector.isSky;
@@ -192,8 +272,8 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
                                                                  mapSegment.isSolid,
                                                                  isSky ? &s_skyHeight : nullptr,
                                                                  nullptr,
-                                                                 frontSector.ceilingTexture,
-                                                                 frontSector.floorTexture,
+                                                                 frontSector.ceilingTextureId,
+                                                                 frontSector.floorTextureId,
                                                                  frontSector.lightLevel);
 
             upperClip.Add(x, outerTexture, 0, std::max(innerTopY, outerTopY));
@@ -206,34 +286,55 @@ void SoftwareRenderer::RenderMapSegmentSpan(const Frame::Span& span, const Visib
                 {
                     Frame::Span           upperSpan {outerSpan.s, innerSpan.s};
                     Frame::PainterContext upperTexture {outerTexture};
-                    upperTexture.textureName = mapSegment.frontSide.upperTexture;
-                    upperTexture.yPegging    = mapSegment.upperUnpegged ? outerTopY : innerTopY;
-                    m_painter->PaintWall(x, upperSpan, upperTexture);
+                    upperTexture.textureId = mapSegment.frontSide.upperTextureId;
+                    upperTexture.yPegging  = mapSegment.upperUnpegged ? outerTopY : innerTopY;
+                    m_painter->QueueWall(upperWalls, x, upperSpan, upperTexture);
                 }
 
                 Frame::Span           lowerSpan {innerSpan.e, outerSpan.e};
                 Frame::PainterContext lowerTexture {outerTexture};
-                lowerTexture.textureName = mapSegment.frontSide.lowerTexture;
-                lowerTexture.yPegging    = mapSegment.lowerUnpegged ? outerTopY : innerBottomY;
-                m_painter->PaintWall(x, lowerSpan, lowerTexture);
+                lowerTexture.textureId = mapSegment.frontSide.lowerTextureId;
+                lowerTexture.yPegging  = mapSegment.lowerUnpegged ? outerTopY : innerBottomY;
+                m_painter->QueueWall(lowerWalls, x, lowerSpan, lowerTexture);
 
                 // if there's a middle texture paint it as sprite (could be semi-transparent)
-                if(outerTexture.textureName != "-")
+                if(outerTexture.textureId != s_noTexture)
                 {
                     m_frame->m_sprites.push_back(std::make_unique<Frame::SpriteWall>(x, innerSpan, outerTexture, projectionDistance));
                 }
             }
         }
     }
+    m_painter->FlushWalls(middleWalls);
+    m_painter->FlushWalls(upperWalls);
+    m_painter->FlushWalls(lowerWalls);
 
     if(mapSegment.isSolid)
     {
         m_frame->m_clips.push_back(middleClip);
+        m_frame->m_numClips++;
     }
     else
     {
         m_frame->m_clips.push_back(upperClip);
         m_frame->m_clips.push_back(lowerClip);
+        m_frame->m_numClips += 2;
+    }
+}
+
+// attach texture name and span count to a plane's trace event, only counted when tracing
+void SoftwareRenderer::TracePlane(TraceScope& trace, const Frame::Plane& plane) const
+{
+    if(trace.IsEnabled())
+    {
+        long long numSpans = plane.columns.size();
+        for(const auto& spans : plane.spans)
+        {
+            numSpans += spans.size();
+        }
+        trace.Arg("spans", numSpans);
+        const auto texture = m_wadFile.GetTexture(plane.textureId);
+        trace.Arg("texture", texture ? texture->name : "-");
     }
 }
 
@@ -242,11 +343,15 @@ void SoftwareRenderer::RenderPlanes() const
 {
     for(const auto& floorPlane : m_frame->m_floorPlanes)
     {
+        TraceScope trace("floor", "planes");
+        TracePlane(trace, floorPlane);
         m_painter->PaintPlane(floorPlane);
         m_frame->m_numFloorPlanes++;
     }
     for(const auto& ceilingPlane : m_frame->m_ceilingPlanes)
     {
+        TraceScope trace("ceiling", "planes");
+        TracePlane(trace, ceilingPlane);
         m_painter->PaintPlane(ceilingPlane);
         m_frame->m_numCeilingPlanes++;
     }
@@ -293,9 +398,9 @@ void SoftwareRenderer::RenderSpriteThing(Frame::SpriteThing* const thing) const
     std::string textureName(thing->textureName);
     if(textureName.length() > 5 && textureName[5] == '1')
     {
-        // check for angle frame
-        const auto angleDiff = Projection::NormalizeAngle(thing->a + PI - m_gameState.m_player.a) + 2 * PI;
-        const char frame     = static_cast<char>((angleDiff + PI4 / 2.0f) / PI4) % 8;
+        // check for angle frame, the top three bits of the binary angle pick one of eight rotations
+        const auto angleDiff = ToBinaryAngle(thing->a) + s_angle180 - ToBinaryAngle(m_gameState.m_player.a);
+        const char frame     = static_cast<char>((angleDiff + s_angle45 / 2) >> 29);
         textureName[5]       = '1' + frame;
         textureName[4]       = 'A' + static_cast<int>(m_gameState.m_step * 2) % 4;
     }
@@ -342,9 +447,9 @@ void SoftwareRenderer::RenderSpriteThing(Frame::SpriteThing* const thing) const
 
     // draw sprite column by column
     Frame::PainterContext spriteContext;
-    spriteContext.textureName = textureName;
-    spriteContext.yScale      = scale;
-    spriteContext.lightness   = m_gameState.m_mapDef->m_sectors[thing->sectorId].lightLevel * m_projection->Lightness(thing->distance);
+    spriteContext.sprite    = texture.get();
+    spriteContext.yScale    = scale;
+    spriteContext.lightness = m_gameState.m_mapDef->m_sectors[thing->sectorId].lightLevel * m_projection->Lightness(thing->distance);
     for(int x = 0; x < spriteWidth; x++)
     {
         const auto screenX = startX + x;
@@ -402,6 +507,16 @@ void SoftwareRenderer::RenderOverlay() const
     // TODO: render HUD etc.
 }
 
+// replace the frame with a heatmap of how many times each pixel was drawn
+void SoftwareRenderer::RenderOverdraw(FrameBuffer& frameBuffer)
+{
+    const auto stats = m_overdrawBuffer->Resolve(frameBuffer);
+
+    m_frameStats.overdraw           = stats.numCoveredPixels ? static_cast<float>(stats.numWrites) / stats.numCoveredPixels : 0;
+    m_frameStats.numOverdrawnPixels = static_cast<int>(stats.numOverdrawnPixels);
+    m_frameStats.maxOverdraw        = stats.maxWrites;
+}
+
 // return the view viewAngle for vertical screen column
 Angle SoftwareRenderer::GetViewAngle(int x, const VisibleSegment& visibleSegment) const
 {
@@ -419,15 +534,44 @@ Angle SoftwareRenderer::GetViewAngle(int x, const VisibleSegment& visibleSegment
     return viewAngle;
 }
 
+// tables are rebuilt for the new resolution by the next frame
+void SoftwareRenderer::Resize(int /*width*/, int /*height*/)
+{
+    m_projectionTables.reset();
+    m_textureCache.reset();
+}
+
 void SoftwareRenderer::SetMode(RenderingMode renderingMode)
 {
     m_renderingMode = renderingMode;
 }
 
+// sample hardware counters around each phase into FrameStats, nullptr to stop
+void SoftwareRenderer::SetPerfCounters(const PerfCounters* perfCounters)
+{
+    m_perfCounters = perfCounters;
+}
+
+// takes effect when the painter is created at the start of the next frame
+void SoftwareRenderer::SetMipmaps(bool mipmaps)
+{
+    m_mipmaps = mipmaps;
+}
+
+void SoftwareRenderer::SetTiledFlats(bool tiledFlats)
+{
+    m_tiledFlats = tiledFlats;
+}
+
 Frame* SoftwareRenderer::GetLastFrame() const
 {
     return m_frame.get();
 }
 
+const FrameStats& SoftwareRenderer::GetFrameStats() const
+{
+    return m_frameStats;
+}
+
 SoftwareRenderer::~SoftwareRenderer() {}
 } // namespace rtdoom
@@ -5,6 +5,10 @@
 #include "Projection.h"
 #include "Frame.h"
 #include "Painter.h"
+#include "TexturePainter.h"
+#include "FrameStats.h"
+#include "Tracer.h"
+#include "OverdrawFrameBuffer.h"
 
 namespace rtdoom
 {
@@ -31,11 +35,17 @@ protected:
     void RenderPlanes() const;
     void RenderSprites() const;
     void RenderOverlay() const;
+    void RenderOverdraw(FrameBuffer& frameBuffer);
     void RenderMapSegment(const Segment& segment) const;
     void RenderMapSegmentSpan(const Frame::Span& span, const VisibleSegment& visibleSegment) const;
     void RenderSpriteThing(Frame::SpriteThing* const thing) const;
     void RenderSpriteWall(Frame::SpriteWall* const wall) const;
 
+    template <typename F>
+    void RunPhase(FrameStats::Phase phase, F&& renderPhase);
+
+    void TracePlane(TraceScope& trace, const Frame::Plane& plane) const;
+
     std::vector<std::vector<bool>> ClipSprite(int startX, int startY, int spriteWidth, int spriteHeight, float spriteScale) const;
     Angle                          GetViewAngle(int x, const VisibleSegment& visibleSegment) const;
 
@@ -45,13 +55,29 @@ protected:
     std::unique_ptr<Frame>      m_frame;
     std::unique_ptr<Painter>    m_painter;
     RendererBase::RenderingMode m_renderingMode;
+    FrameStats                  m_frameStats;
+    const PerfCounters*         m_perfCounters;
+    bool                        m_mipmaps;
+    bool                        m_tiledFlats;
+
+    // painters draw here instead of the frame buffer in Overdraw mode
+    std::unique_ptr<OverdrawFrameBuffer> m_overdrawBuffer;
+
+    // depend only on the resolution, kept across frames until the viewport is resized
+    std::shared_ptr<const ProjectionTables> m_projectionTables;
+    std::shared_ptr<TexturePainter::Cache>  m_textureCache;
 
 public:
     SoftwareRenderer(const GameState& gameState, const WADFile& wadFile);
     ~SoftwareRenderer();
 
     virtual void RenderFrame(FrameBuffer& frameBuffer) override;
-    Frame*       GetLastFrame() const;
+    virtual void Resize(int width, int height) override;
+    Frame*            GetLastFrame() const;
+    const FrameStats& GetFrameStats() const;
     void         SetMode(RendererBase::RenderingMode renderingMode);
+    void         SetPerfCounters(const PerfCounters* perfCounters);
+    void         SetMipmaps(bool mipmaps);
+    void         SetTiledFlats(bool tiledFlats);
 };
 } // namespace rtdoom
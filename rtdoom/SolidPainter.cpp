@@ -9,7 +9,7 @@ SolidPainter::SolidPainter(FrameBuffer& frameBuffer, const Projection& projectio
 
 void SolidPainter::PaintWall(int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const
 {
-    if(textureContext.textureName != "-")
+    if(textureContext.textureId != s_noTexture)
     {
         m_frameBuffer.VerticalLine(x, span.s, span.e, s_wallColor, textureContext.lightness);
     }
@@ -24,12 +24,15 @@ void SolidPainter::PaintSprite(int /*x*/,
 void SolidPainter::PaintPlane(const Frame::Plane& plane) const
 {
     const bool isSky = plane.isSky();
+    for(const auto& column : plane.columns)
+    {
+        m_frameBuffer.VerticalLine(column.x, column.span.s, column.span.e, s_planeColor, 1);
+    }
 
     for(size_t y = 0; y < plane.spans.size(); y++)
     {
-        const auto& spans          = plane.spans[y];
-        auto        centerDistance = m_projection.PlaneDistance(y, plane.h);
-        const float lightness      = isSky ? 1 : m_projection.Lightness(centerDistance) * plane.lightLevel;
+        const auto& spans     = plane.spans[y];
+        const float lightness = isSky ? 1 : m_projection.PlaneLightness(y, plane.h) * plane.lightLevel;
 
         for(auto span : spans)
         {
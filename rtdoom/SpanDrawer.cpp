@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "SpanDrawer.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define RTDOOM_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define RTDOOM_AVX2
+#else
+#define RTDOOM_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace rtdoom
+{
+void SpanDrawer::DrawScalar(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels) noexcept
+{
+    const auto uMask = (1u << span.widthBits) - 1;
+    const auto vMask = (1u << span.heightBits) - 1;
+    auto       u     = span.u;
+    auto       v     = span.v;
+    if(span.tiled)
+    {
+        for(auto i = 0; i < numPixels; i++)
+        {
+            pixels[i] = colors[span.pixels[TextureSpan::TiledOffset((u >> 16) & uMask, (v >> 16) & vMask, span.widthBits)]];
+            u += span.du;
+            v += span.dv;
+        }
+        return;
+    }
+    for(auto i = 0; i < numPixels; i++)
+    {
+        pixels[i] = colors[span.pixels[(((v >> 16) & vMask) << span.widthBits) | ((u >> 16) & uMask)]];
+        u += span.du;
+        v += span.dv;
+    }
+}
+
+#if defined(RTDOOM_X64)
+// texels are gathered as dwords and masked to their low byte, textures are padded so that the last one can be read this way
+RTDOOM_AVX2 void SpanDrawer::DrawAVX2(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels) noexcept
+{
+    constexpr int tileBits = TextureSpan::s_tileBits;
+
+    const auto lanes    = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const auto uMask    = _mm256_set1_epi32((1 << span.widthBits) - 1);
+    const auto vMask    = _mm256_set1_epi32((1 << span.heightBits) - 1);
+    const auto byteMask = _mm256_set1_epi32(0xff);
+    const auto vShift   = _mm_cvtsi32_si128(span.widthBits);
+    const auto tileMask = _mm256_set1_epi32((1 << tileBits) - 1);
+    const auto rowShift = _mm_cvtsi32_si128(span.widthBits + tileBits);
+    const auto du       = _mm256_set1_epi32(static_cast<int>(span.du * 8));
+    const auto dv       = _mm256_set1_epi32(static_cast<int>(span.dv * 8));
+    const auto texels   = reinterpret_cast<const int*>(span.pixels);
+    const auto palette  = reinterpret_cast<const int*>(colors);
+
+    auto u = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(span.u)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(span.du)));
+    auto v = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(span.v)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(span.dv)));
+    auto i = 0;
+    for(; i + 8 <= numPixels; i += 8)
+    {
+        const auto tu = _mm256_and_si256(_mm256_srli_epi32(u, 16), uMask);
+        const auto tv = _mm256_and_si256(_mm256_srli_epi32(v, 16), vMask);
+
+        __m256i offsets;
+        if(span.tiled)
+        {
+            const auto tiles  = _mm256_or_si256(_mm256_sll_epi32(_mm256_srli_epi32(tv, tileBits), rowShift),
+                                               _mm256_slli_epi32(_mm256_srli_epi32(tu, tileBits), 2 * tileBits));
+            const auto inTile = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(tv, tileMask), tileBits), _mm256_and_si256(tu, tileMask));
+            offsets           = _mm256_or_si256(tiles, inTile);
+        }
+        else
+        {
+            offsets = _mm256_or_si256(_mm256_sll_epi32(tv, vShift), tu);
+        }
+        const auto texel = _mm256_and_si256(_mm256_i32gather_epi32(texels, offsets, 1), byteMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), _mm256_i32gather_epi32(palette, texel, 4));
+        u = _mm256_add_epi32(u, du);
+        v = _mm256_add_epi32(v, dv);
+    }
+
+    // the last few pixels continue where the vectors stopped
+    auto tail = span;
+    tail.u += i * span.du;
+    tail.v += i * span.dv;
+    DrawScalar(tail, numPixels - i, colors, pixels + i);
+}
+
+bool SpanDrawer::HasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+    {
+        return false;
+    }
+    // the OS has to save the YMM registers as well
+    __cpuid(info, 1);
+    const bool hasAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+    if(!hasAVX || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#else
+void SpanDrawer::DrawAVX2(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels) noexcept
+{
+    DrawScalar(span, numPixels, colors, pixels);
+}
+
+bool SpanDrawer::HasAVX2()
+{
+    return false;
+}
+#endif
+
+SpanDrawer::DrawFunction SpanDrawer::Select()
+{
+    static const DrawFunction drawFunction = HasAVX2() ? DrawAVX2 : DrawScalar;
+    return drawFunction;
+}
+
+int SpanDrawer::SizeBits(int size)
+{
+    for(auto bits = 0; bits < 16; bits++)
+    {
+        if(size == 1 << bits)
+        {
+            return bits;
+        }
+    }
+    return -1;
+}
+} // namespace rtdoom
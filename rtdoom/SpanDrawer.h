@@ -0,0 +1,57 @@
+#pragma once
+
+namespace rtdoom
+{
+// floor or ceiling span across a power-of-two texture, coordinates are 16.16 fixed point and wrap around the texture size
+struct TextureSpan
+{
+    // tiled textures are stored in 8x8 texel tiles, so that a span crosses the same number of cache lines at any angle
+    static constexpr int s_tileBits = 3;
+
+    const unsigned char* pixels;
+    int                  widthBits;
+    int                  heightBits;
+    uint32_t             u; // texel coordinates of the first pixel
+    uint32_t             v;
+    uint32_t             du; // steps per pixel
+    uint32_t             dv;
+    bool                 tiled = false; // pixels are laid out by TiledOffset, both sizes are at least a tile
+
+    // tiles go row by row across the texture and texels row by row within a tile
+    static uint32_t TiledOffset(uint32_t tu, uint32_t tv, int widthBits) noexcept
+    {
+        constexpr uint32_t tileMask = (1u << s_tileBits) - 1;
+        return ((tv >> s_tileBits) << (widthBits + s_tileBits)) | ((tu >> s_tileBits) << (2 * s_tileBits)) |
+               ((tv & tileMask) << s_tileBits) | (tu & tileMask);
+    }
+
+    unsigned char Texel(uint32_t n) const noexcept
+    {
+        const auto tu = ((u + n * du) >> 16) & ((1u << widthBits) - 1);
+        const auto tv = ((v + n * dv) >> 16) & ((1u << heightBits) - 1);
+        return pixels[tiled ? TiledOffset(tu, tv, widthBits) : (tv << widthBits) | tu];
+    }
+};
+
+// kernels painting a texture span as lit ARGB pixels from pixels[0] forwards, all of them produce identical output
+class SpanDrawer
+{
+public:
+    static constexpr float s_fracUnit = 65536.0f;
+
+    using DrawFunction = void (*)(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels);
+
+    static void DrawScalar(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels) noexcept;
+
+    // 8 pixels per iteration with AVX2 gathers, only to be called when HasAVX2()
+    static void DrawAVX2(const TextureSpan& span, int numPixels, const uint32_t* colors, uint32_t* pixels) noexcept;
+
+    static bool HasAVX2();
+
+    // fastest kernel the CPU supports, detected once
+    static DrawFunction Select();
+
+    // log2 of a texture size, -1 when it is not a power of two
+    static int SizeBits(int size);
+};
+} // namespace rtdoom
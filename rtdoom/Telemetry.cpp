@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "Telemetry.h"
+
+#include <numeric>
+
+namespace rtdoom
+{
+Telemetry::Telemetry(const std::string& csvFileName, double summaryInterval, size_t windowSize) :
+    m_records {std::make_unique<RingBuffer<Record, s_capacity>>()}, m_isRunning {false}, m_numDropped {0}, m_csvFileName {csvFileName},
+    m_summaryInterval {summaryInterval}, m_windowSize {windowSize}, m_numFrames {0}, m_numRenderedFrames {0}, m_numSummaryFrames {0}
+{
+    m_frameTimes.reserve(m_windowSize);
+    m_renderTimes.reserve(m_windowSize);
+}
+
+void Telemetry::Start()
+{
+    if(!m_csvFileName.empty())
+    {
+        m_csvFile.open(m_csvFileName);
+        if(!m_csvFile.is_open())
+        {
+            throw std::runtime_error("Unable to open telemetry file " + m_csvFileName);
+        }
+        m_csvFile << "frame,frame_ms,render_ms";
+        for(size_t i = 0; i < FrameStats::s_numPhases; i++)
+        {
+            m_csvFile << "," << FrameStats::PhaseName(static_cast<FrameStats::Phase>(i)) << "_ms";
+        }
+        m_csvFile << ",segments,floors,ceilings,sprites,visplanes,clips,subsectors,pixels,texels,allocations,allocated_bytes,overdraw"
+                  << std::endl;
+    }
+
+    m_lastSummary = std::chrono::steady_clock::now();
+    m_isRunning   = true;
+    m_consumer    = std::thread(&Telemetry::Consume, this);
+}
+
+void Telemetry::Stop()
+{
+    if(m_isRunning.exchange(false))
+    {
+        m_consumer.join();
+        if(m_summaryInterval > 0 && m_numSummaryFrames > 0)
+        {
+            PrintSummary();
+        }
+        m_csvFile.close();
+    }
+}
+
+void Telemetry::Push(double frameTime, const FrameStats* frameStats)
+{
+    Record record;
+    record.frameTime = frameTime;
+    record.hasStats  = frameStats != nullptr;
+    if(record.hasStats)
+    {
+        record.stats = *frameStats;
+    }
+    if(!m_records->TryPush(record))
+    {
+        m_numDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// polls instead of waiting on a condition so that the game loop never touches a lock
+void Telemetry::Consume()
+{
+    Record record;
+    while(true)
+    {
+        const auto isRunning = m_isRunning.load();
+        while(m_records->TryPop(record))
+        {
+            Process(record);
+        }
+        if(!isRunning)
+        {
+            break;
+        }
+
+        if(m_summaryInterval > 0 && m_numSummaryFrames > 0 &&
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastSummary).count() >= m_summaryInterval)
+        {
+            PrintSummary();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+void Telemetry::Process(const Record& record)
+{
+    if(m_frameTimes.size() < m_windowSize)
+    {
+        m_frameTimes.push_back(record.frameTime);
+    }
+    else
+    {
+        m_frameTimes[m_numFrames % m_windowSize] = record.frameTime;
+    }
+
+    // OpenGL frames have no stats and don't count towards the rendering average
+    if(record.hasStats)
+    {
+        if(m_renderTimes.size() < m_windowSize)
+        {
+            m_renderTimes.push_back(record.stats.frameTime);
+        }
+        else
+        {
+            m_renderTimes[m_numRenderedFrames % m_windowSize] = record.stats.frameTime;
+        }
+        m_numRenderedFrames++;
+        m_lastStats = record.stats;
+    }
+
+    if(m_csvFile.is_open())
+    {
+        const auto& stats = record.stats;
+        m_csvFile << m_numFrames << "," << record.frameTime;
+        if(record.hasStats)
+        {
+            m_csvFile << "," << stats.frameTime;
+            for(const auto phaseTime : stats.phaseTimes)
+            {
+                m_csvFile << "," << phaseTime;
+            }
+            m_csvFile << "," << stats.numSegments << "," << stats.numFloorPlanes << "," << stats.numCeilingPlanes << "," << stats.numSprites
+                      << "," << stats.numVisplanes << "," << stats.numClips << "," << stats.numSubSectors << "," << stats.numPixels << ","
+                      << stats.numTexels << "," << stats.frameAllocations.numAllocations << "," << stats.frameAllocations.numBytes << ","
+                      << stats.overdraw;
+        }
+        m_csvFile << "\n";
+    }
+
+    m_numFrames++;
+    m_numSummaryFrames++;
+}
+
+void Telemetry::PrintSummary()
+{
+    const auto now     = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::duration<double>(now - m_lastSummary).count();
+
+    std::vector<double> frameTimes(m_frameTimes);
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    // nearest-rank percentiles over the window
+    const auto percentile = [&frameTimes](double p) {
+        const auto rank = static_cast<size_t>(std::ceil(p * frameTimes.size()));
+        return frameTimes[std::clamp(rank, static_cast<size_t>(1), frameTimes.size()) - 1];
+    };
+
+    std::ostringstream summary;
+    summary << m_numSummaryFrames / elapsed << " fps, frame time p50 " << percentile(0.5) << "ms, p95 " << percentile(0.95) << "ms, p99 "
+            << percentile(0.99) << "ms, max " << frameTimes.back() << "ms over " << frameTimes.size() << " frames";
+    if(!m_renderTimes.empty())
+    {
+        summary << ", rendering avg " << std::accumulate(m_renderTimes.begin(), m_renderTimes.end(), 0.0) / m_renderTimes.size()
+                << "ms, last " << m_lastStats;
+    }
+    const auto numDropped = m_numDropped.exchange(0);
+    if(numDropped > 0)
+    {
+        summary << ", " << numDropped << " records dropped";
+    }
+    std::cout << summary.str() << std::endl;
+
+    m_lastSummary      = now;
+    m_numSummaryFrames = 0;
+}
+
+Telemetry::~Telemetry()
+{
+    Stop();
+}
+} // namespace rtdoom
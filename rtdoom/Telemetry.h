@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FrameStats.h"
+#include "RingBuffer.h"
+
+namespace rtdoom
+{
+// collects per-frame statistics off the game loop: frames are queued without locking or I/O
+// and a background thread keeps rolling percentiles, writes the optional CSV and prints periodic summaries
+class Telemetry
+{
+public:
+    struct Record
+    {
+        double     frameTime; // ms between frames, as seen by the game loop
+        bool       hasStats;  // false in OpenGL mode
+        FrameStats stats;
+    };
+
+    // summaryInterval in seconds, 0 disables summaries; windowSize is the number of recent frames percentiles are taken from
+    Telemetry(const std::string& csvFileName, double summaryInterval, size_t windowSize = 1000);
+    ~Telemetry();
+
+    void Start();
+    void Stop();
+
+    // called once per frame by the game loop, never blocks: records are dropped when the consumer falls behind
+    void Push(double frameTime, const FrameStats* frameStats);
+
+protected:
+    constexpr static size_t s_capacity = 1024;
+
+    void Consume();
+    void Process(const Record& record);
+    void PrintSummary();
+
+    std::unique_ptr<RingBuffer<Record, s_capacity>> m_records;
+    std::atomic<bool>                               m_isRunning;
+    std::atomic<size_t>                             m_numDropped;
+    std::thread                                     m_consumer;
+
+    // consumer thread state
+    std::string                           m_csvFileName;
+    std::ofstream                         m_csvFile;
+    double                                m_summaryInterval;
+    std::chrono::steady_clock::time_point m_lastSummary;
+    std::vector<double>                   m_frameTimes; // circular window of recent frame times
+    std::vector<double>                   m_renderTimes; // same for frames rendered in software
+    size_t                                m_windowSize;
+    size_t                                m_numFrames;
+    size_t                                m_numRenderedFrames;
+    size_t                                m_numSummaryFrames;
+    FrameStats                            m_lastStats;
+};
+} // namespace rtdoom
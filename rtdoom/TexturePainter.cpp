@@ -5,83 +5,268 @@
 
 namespace rtdoom
 {
-TexturePainter::TexturePainter(FrameBuffer& frameBuffer, const Thing& pov, const Projection& projection, const WADFile& wadFile) :
-    Painter {frameBuffer}, m_pov {pov}, m_projection {projection}, m_wadFile {wadFile}
+TexturePainter::TexturePainter(FrameBuffer&           frameBuffer,
+                               const Thing&           pov,
+                               const Projection&      projection,
+                               const WADFile&         wadFile,
+                               bool                   mipmaps,
+                               bool                   tiledFlats,
+                               std::shared_ptr<Cache> cache) :
+    Painter {frameBuffer}, m_pov {pov}, m_projection {projection}, m_wadFile {wadFile},
+    m_skyTexture {wadFile.GetTexture(wadFile.TextureId("SKY1"))}, m_mipmaps {mipmaps}, m_tiledFlats {tiledFlats},
+    m_cache {cache ? std::move(cache) : std::make_shared<Cache>()}
 {}
 
-void TexturePainter::PaintWall(int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const
+// the smallest level whose texels are still no further apart than screen pixels, step is in full-size texels per pixel
+int TexturePainter::SelectMipLevel(const Texture& texture, float step) const
 {
-    if(textureContext.textureName.length() && textureContext.textureName[0] != '-')
+    auto level = 0;
+    if(m_mipmaps)
     {
-        const auto it = m_wadFile.m_textures.find(textureContext.textureName);
-        if(it == m_wadFile.m_textures.end())
+        const auto numLevels = static_cast<int>(texture.mipLevels.size());
+        while(level < numLevels && step >= 2.0f)
         {
-            return;
+            step *= 0.5f;
+            level++;
         }
-        const auto& texture = it->second;
-        const auto  tx      = Helpers::Clip(static_cast<int>(textureContext.texelX), texture->width);
+    }
+    return level;
+}
 
-        const auto       sy = std::max(0, span.s);
-        const auto       ey = std::min(m_frameBuffer.m_height - 1, span.e);
-        const auto       ny = ey - sy + 1;
-        std::vector<int> texels(ny);
+// masks wrap power-of-two sizes, which gives the same texel as clipping
+int TexturePainter::WrapTexel(int v, int mask, int size)
+{
+    return mask != TexelColumns::s_noMask ? v & mask : Helpers::Clip(v, size);
+}
 
-        const float vStep = textureContext.yScale;
-        float       vs    = (sy - textureContext.yPegging) * vStep;
+// fills texels of the on-screen part of a wall column and returns the row it starts at
+int TexturePainter::WallTexels(const Texture&               texture,
+                               const Frame::Span&           span,
+                               const Frame::PainterContext& textureContext,
+                               std::vector<int>&            texels) const
+{
+    const auto  level   = SelectMipLevel(texture, textureContext.yScale);
+    const auto& columns = level ? texture.mipLevels[level - 1].columns : texture.columns;
+    const auto  width   = texture.width >> level;
+    const auto  height  = texture.height >> level;
+    const auto  yOffset = textureContext.yOffset >> level;
+    const auto  column  = columns.Column(WrapTexel(static_cast<int>(textureContext.texelX) >> level, columns.widthMask, width));
+
+    const auto sy = std::max(0, span.s);
+    const auto ey = std::min(m_frameBuffer.m_height - 1, span.e);
+    const auto ny = std::max(0, ey - sy + 1);
+    texels.resize(ny);
+
+    const float vStep = textureContext.yScale / (1 << level);
+    float       vs    = (sy - textureContext.yPegging) * vStep;
+    if constexpr(Projection::s_useFixedPoint)
+    {
+        // converted once per column, texel rows are then the integer part of the stepper
+        const auto fixedStep = Fixed::FromFloat(vStep).raw;
+        auto       fixedV    = Fixed::FromFloat(vs).raw;
+        for(auto dy = sy; dy <= ey; dy++)
+        {
+            texels[dy - sy] = column[WrapTexel((fixedV >> Fixed::s_fracBits) + yOffset, columns.heightMask, height)];
+            fixedV += fixedStep;
+        }
+    }
+    else if(columns.heightMask != TexelColumns::s_noMask)
+    {
         for(auto dy = sy; dy <= ey; dy++)
         {
-            const auto ty   = Helpers::Clip(static_cast<int>(vs) + textureContext.yOffset, texture->height);
-            texels[dy - sy] = texture->pixels[ty * texture->width + tx];
+            texels[dy - sy] = column[(static_cast<int>(vs) + yOffset) & columns.heightMask];
             vs += vStep;
         }
+    }
+    else
+    {
+        for(auto dy = sy; dy <= ey; dy++)
+        {
+            texels[dy - sy] = column[Helpers::Clip(static_cast<int>(vs) + yOffset, height)];
+            vs += vStep;
+        }
+    }
+    m_numTexels += ny;
+    return sy;
+}
+
+void TexturePainter::PaintWall(int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const
+{
+    const auto texture = m_wadFile.GetTexture(textureContext.textureId);
+    if(texture)
+    {
+        std::vector<int> texels;
+        const auto       sy = WallTexels(*texture, span, textureContext, texels);
         m_frameBuffer.VerticalLine(x, sy, texels, textureContext.lightness);
     }
 }
 
+// neighbouring columns of a wall section share the texture and are handed to the frame buffer together to be written row by row
+void TexturePainter::PaintWalls(const WallColumns& walls) const
+{
+    const auto texture = m_wadFile.GetTexture(walls.contexts[0].textureId);
+    if(texture)
+    {
+        std::array<TexelColumn, WallColumns::s_maxColumns> columns;
+        for(auto i = 0; i < walls.numColumns; i++)
+        {
+            columns[i].sy        = WallTexels(*texture, walls.spans[i], walls.contexts[i], m_cache->wallTexels[i]);
+            columns[i].texels    = &m_cache->wallTexels[i];
+            columns[i].lightness = walls.contexts[i].lightness;
+        }
+        m_frameBuffer.VerticalLines(walls.x, walls.numColumns, columns.data());
+    }
+}
+
 void TexturePainter::PaintSprite(int x, int sy, std::vector<bool> occlusion, const Frame::PainterContext& textureContext) const
 {
-    auto it = m_wadFile.m_sprites.find(textureContext.textureName);
-    if(it == m_wadFile.m_sprites.end())
+    const auto sprite = textureContext.sprite;
+    if(sprite == nullptr)
     {
         return;
     }
-    const auto& sprite = it->second;
 
     std::vector<int> texels;
     texels.reserve(occlusion.size());
-    const float vStep = textureContext.yScale;
-    const auto  tx    = Helpers::Clip(static_cast<int>(textureContext.texelX), sprite->width);
-    float       vs    = 0;
-    for(auto o : occlusion)
+    const auto& columns = sprite->columns;
+    const auto  column  = columns.Column(WrapTexel(static_cast<int>(textureContext.texelX), columns.widthMask, sprite->width));
+    const float vStep   = textureContext.yScale;
+    if constexpr(Projection::s_useFixedPoint)
     {
-        if(!o)
+        // the fixed point stepper replaces the float one and its conversion per texel
+        const auto fixedStep = Fixed::FromFloat(vStep).raw;
+        auto       fixedV    = 0;
+        for(auto o : occlusion)
         {
-            const auto ty = Helpers::Clip(static_cast<int>(vs) + textureContext.yOffset, sprite->height);
-            texels.push_back(sprite->pixels[ty * sprite->width + tx]);
+            if(!o)
+            {
+                const auto ty = fixedV >> Fixed::s_fracBits;
+                texels.push_back(column[WrapTexel(ty + textureContext.yOffset, columns.heightMask, sprite->height)]);
+                m_numTexels++;
+            }
+            else
+            {
+                texels.push_back(247);
+            }
+            fixedV += fixedStep;
         }
-        else
+    }
+    else
+    {
+        float vs = 0;
+        for(auto o : occlusion)
         {
-            texels.push_back(247);
+            if(!o)
+            {
+                const auto ty = static_cast<int>(vs);
+                texels.push_back(column[WrapTexel(ty + textureContext.yOffset, columns.heightMask, sprite->height)]);
+                m_numTexels++;
+            }
+            else
+            {
+                texels.push_back(247);
+            }
+            vs += vStep;
         }
-        vs += vStep;
     }
     m_frameBuffer.VerticalLine(x, sy, texels, textureContext.lightness);
 }
 
+// the sky's texture column only depends on the screen column and the view angle and its texture row only on the screen row,
+// so both are looked up in the cache, columns again when the player turns, and each column is then a scaled vertical copy
+void TexturePainter::PaintSky(const Frame::Plane& plane) const
+{
+    if(m_skyTexture == nullptr)
+    {
+        return;
+    }
+
+    const auto& texture = *m_skyTexture;
+    auto&       cache   = *m_cache;
+    if(cache.skyTexture != &texture)
+    {
+        cache.skyTexture = &texture;
+        cache.skyColumns.clear();
+        cache.skyRows.clear();
+    }
+    if(cache.skyColumns.empty() || cache.skyAngle != m_pov.a)
+    {
+        const auto xScale = 1.0f / PI4 * texture.width;
+        cache.skyColumns.resize(m_frameBuffer.m_width);
+        for(auto x = 0; x < m_frameBuffer.m_width; x++)
+        {
+            const auto viewAngle = m_projection.ViewAngle(x);
+            cache.skyColumns[x]  = texture.columns.Column(Helpers::Clip(static_cast<int>((m_pov.a + viewAngle) * xScale), texture.width));
+        }
+        cache.skyAngle = m_pov.a;
+    }
+    if(cache.skyRows.empty())
+    {
+        const auto horizon = m_frameBuffer.m_height / 2.0f;
+        cache.skyRows.resize(m_frameBuffer.m_height);
+        for(auto y = 0; y < m_frameBuffer.m_height; y++)
+        {
+            cache.skyRows[y] = Helpers::Clip(static_cast<int>(y / horizon / 2.0f * texture.height), texture.height);
+        }
+    }
+
+    // adjacent columns are painted together like walls
+    std::array<TexelColumn, WallColumns::s_maxColumns> columns;
+    auto                                               x          = 0;
+    auto                                               numColumns = 0;
+    for(const auto& column : plane.columns)
+    {
+        if(numColumns == WallColumns::s_maxColumns || (numColumns > 0 && column.x != x + numColumns))
+        {
+            m_frameBuffer.VerticalLines(x, numColumns, columns.data());
+            numColumns = 0;
+        }
+        if(numColumns == 0)
+        {
+            x = column.x;
+        }
+
+        const auto sy     = std::max(0, column.span.s);
+        const auto ey     = std::min(m_frameBuffer.m_height - 1, column.span.e);
+        const auto texels = cache.skyColumns[column.x];
+        auto&      copy   = cache.wallTexels[numColumns];
+        copy.resize(ey - sy + 1);
+        for(auto y = sy; y <= ey; y++)
+        {
+            copy[y - sy] = texels[cache.skyRows[y]];
+        }
+        m_numTexels += copy.size();
+        columns[numColumns++] = {sy, &copy, 1};
+    }
+    if(numColumns > 0)
+    {
+        m_frameBuffer.VerticalLines(x, numColumns, columns.data());
+    }
+}
+
 void TexturePainter::PaintPlane(const Frame::Plane& plane) const
 {
-    const bool isSky = plane.isSky();
-    auto       it    = m_wadFile.m_textures.find(isSky ? "SKY1" : plane.textureName);
-    if(it == m_wadFile.m_textures.end())
+    if(plane.isSky())
+    {
+        PaintSky(plane);
+        return;
+    }
+
+    const auto texture = m_wadFile.GetTexture(plane.textureId);
+    if(texture == nullptr)
     {
         return;
     }
 
-    const auto& texture = it->second;
-    const auto  angle   = Projection::NormalizeAngle(m_pov.a);
-    const auto  cosA    = MathCache::instance().Cos(angle);
-    const auto  sinA    = MathCache::instance().Sin(angle);
-    const auto  aStep   = PI4 / (m_frameBuffer.m_width / 2);
+    const auto angle = ToBinaryAngle(m_pov.a);
+    const auto cosA  = MathCache::instance().Cos(angle);
+    const auto sinA  = MathCache::instance().Sin(angle);
+    const auto aStep = PI4 / (m_frameBuffer.m_width / 2);
+
+    // flats are power-of-two sized and stepped in fixed point, which lets span kernels wrap coordinates with masks
+    const auto widthBits  = SpanDrawer::SizeBits(texture->width);
+    const auto heightBits = SpanDrawer::SizeBits(texture->height);
+    const auto isFixed    = widthBits >= 0 && heightBits >= 0;
 
     // floors/ceilings are most efficient painted in horizontal strips since distance to the player is constant
     for(size_t y = 0; y < plane.spans.size(); y++)
@@ -92,63 +277,61 @@ void TexturePainter::PaintPlane(const Frame::Plane& plane) const
             continue;
         }
 
-        auto mergedSpans = MergeSpans(spans);
-        if(!isSky)
+        const auto mergedSpans    = MergeSpans(spans);
+        const auto centerDistance = m_projection.PlaneDistance(y, plane.h);
+        if(isfinite(centerDistance) && centerDistance > s_minDistance)
         {
-            const auto centerDistance = m_projection.PlaneDistance(y, plane.h);
-            if(isfinite(centerDistance) && centerDistance > s_minDistance)
+            const float lightness = m_projection.PlaneLightness(y, plane.h) * plane.lightLevel;
+            const auto  ccosA     = centerDistance * cosA;
+            const auto  csinA     = centerDistance * sinA;
+
+            // texel steps per horizontal pixel
+            const auto stepX = -csinA * aStep;
+            const auto stepY = ccosA * aStep;
+
+            for(const auto& span : mergedSpans)
             {
-                const float lightness = m_projection.Lightness(centerDistance) * plane.lightLevel;
-                const auto  ccosA     = centerDistance * cosA;
-                const auto  csinA     = centerDistance * sinA;
+                const auto sx       = std::max(0, span.s);
+                const auto ex       = std::min(m_frameBuffer.m_width - 1, span.e);
+                const auto nx       = ex - sx + 1;
+                const auto angleTan = aStep * (sx - m_frameBuffer.m_width / 2);
 
-                // texel steps per horizontal pixel
-                const auto stepX = -csinA * aStep;
-                const auto stepY = ccosA * aStep;
+                // starting texel position
+                auto texelX = Helpers::Clip(m_pov.x + ccosA - csinA * angleTan, static_cast<float>(texture->width));
+                auto texelY = Helpers::Clip(m_pov.y + csinA + ccosA * angleTan, static_cast<float>(texture->height));
 
-                for(const auto& span : mergedSpans)
+                m_numTexels += nx;
+                if(isFixed)
                 {
-                    const auto sx       = std::max(0, span.s);
-                    const auto ex       = std::min(m_frameBuffer.m_width - 1, span.e);
-                    const auto nx       = ex - sx + 1;
-                    const auto angleTan = aStep * (sx - m_frameBuffer.m_width / 2);
-
-                    // starting texel position
-                    auto texelX = Helpers::Clip(m_pov.x + ccosA - csinA * angleTan, static_cast<float>(texture->width));
-                    auto texelY = Helpers::Clip(m_pov.y + csinA + ccosA * angleTan, static_cast<float>(texture->height));
-
-                    std::vector<int> texels(nx);
-                    for(auto x = sx; x <= ex; x++)
-                    {
-                        const auto tx  = Helpers::Clip(static_cast<int>(texelX), texture->width);
-                        const auto ty  = Helpers::Clip(static_cast<int>(texelY), texture->height);
-                        texels[x - sx] = texture->pixels[texture->width * ty + tx];
-                        texelX += stepX;
-                        texelY += stepY;
-                    }
-                    m_frameBuffer.HorizontalLine(sx, y, texels, lightness);
+                    // fixed point coordinates are scaled down to the level together with the texture
+                    const auto level     = SelectMipLevel(*texture, centerDistance * aStep);
+                    const auto fracScale = SpanDrawer::s_fracUnit / (1 << level);
+                    const auto mipLevel  = level ? &texture->mipLevels[level - 1] : nullptr;
+                    const auto rows      = mipLevel ? mipLevel->pixels.get() : texture->pixels.get();
+                    const auto tiles     = !m_tiledFlats ? nullptr : mipLevel ? mipLevel->tiles.get() : texture->tiles.get();
+
+                    const TextureSpan textureSpan {tiles ? tiles : rows,
+                                                   widthBits - level,
+                                                   heightBits - level,
+                                                   static_cast<uint32_t>(texelX * fracScale),
+                                                   static_cast<uint32_t>(texelY * fracScale),
+                                                   static_cast<uint32_t>(static_cast<int32_t>(stepX * fracScale)),
+                                                   static_cast<uint32_t>(static_cast<int32_t>(stepY * fracScale)),
+                                                   tiles != nullptr};
+                    m_frameBuffer.HorizontalSpan(sx, ex, y, textureSpan, lightness);
+                    continue;
                 }
-            }
-        }
-        else
-        {
-            const auto horizon = m_frameBuffer.m_height / 2.0f;
-            const auto ty      = Helpers::Clip(static_cast<int>(y / horizon / 2.0f * texture->height), texture->height);
-            const auto xScale  = 1.0f / PI4 * texture->width;
-            for(const auto& span : mergedSpans)
-            {
-                const auto sx = std::max(0, span.s);
-                const auto ex = std::min(m_frameBuffer.m_width - 1, span.e);
-                const auto nx = ex - sx + 1;
 
                 std::vector<int> texels(nx);
                 for(auto x = sx; x <= ex; x++)
                 {
-                    const auto viewAngle = m_projection.ViewAngle(x);
-                    const auto tx        = Helpers::Clip(static_cast<int>((m_pov.a + viewAngle) * xScale), texture->width);
-                    texels[x - sx]       = texture->pixels[texture->width * ty + tx];
+                    const auto tx  = Helpers::Clip(static_cast<int>(texelX), texture->width);
+                    const auto ty  = Helpers::Clip(static_cast<int>(texelY), texture->height);
+                    texels[x - sx] = texture->pixels[texture->width * ty + tx];
+                    texelX += stepX;
+                    texelY += stepY;
                 }
-                m_frameBuffer.HorizontalLine(sx, y, texels, 1);
+                m_frameBuffer.HorizontalLine(sx, y, texels, lightness);
             }
         }
     }
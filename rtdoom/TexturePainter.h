@@ -6,19 +6,55 @@ namespace rtdoom
 {
 class TexturePainter : public Painter
 {
+public:
+    // buffers and lookups that outlive a frame's painter, only valid for one resolution
+    struct Cache
+    {
+        // texels of the columns painted by PaintWalls and PaintSky
+        std::array<std::vector<int>, WallColumns::s_maxColumns> wallTexels;
+
+        // sky texture column of each screen column at skyAngle, and sky texture row of each screen row
+        const Texture*                    skyTexture {nullptr};
+        std::vector<const unsigned char*> skyColumns;
+        std::vector<int>                  skyRows;
+        Angle                             skyAngle {0};
+    };
+
 protected:
-    const Thing&      m_pov;
-    const Projection& m_projection;
-    const WADFile&    m_wadFile;
+    const Thing&           m_pov;
+    const Projection&      m_projection;
+    const WADFile&         m_wadFile;
+    const Texture*         m_skyTexture;
+    const bool             m_mipmaps;
+    const bool             m_tiledFlats;
+    std::shared_ptr<Cache> m_cache;
+
+    int WallTexels(const Texture&               texture,
+                   const Frame::Span&           span,
+                   const Frame::PainterContext& textureContext,
+                   std::vector<int>&            texels) const;
+
+    static int WrapTexel(int v, int mask, int size);
+
+    int SelectMipLevel(const Texture& texture, float step) const;
 
     static std::list<Frame::Span> MergeSpans(const std::vector<Frame::Span>& spans);
 
+    void PaintSky(const Frame::Plane& plane) const;
+
 public:
     void PaintWall(int x, const Frame::Span& span, const Frame::PainterContext& textureContext) const override;
+    void PaintWalls(const WallColumns& walls) const override;
     void PaintSprite(int x, int sy, std::vector<bool> occlusion, const Frame::PainterContext& textureContext) const override;
     void PaintPlane(const Frame::Plane& plane) const override;
 
-    TexturePainter(FrameBuffer& frameBuffer, const Thing& pov, const Projection& projection, const WADFile& wadFile);
+    TexturePainter(FrameBuffer&           frameBuffer,
+                   const Thing&           pov,
+                   const Projection&      projection,
+                   const WADFile&         wadFile,
+                   bool                   mipmaps    = true,
+                   bool                   tiledFlats = true,
+                   std::shared_ptr<Cache> cache      = nullptr);
     ~TexturePainter();
 };
 } // namespace rtdoom
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "Tracer.h"
+
+namespace rtdoom
+{
+std::atomic<bool> Tracer::s_isEnabled {false};
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+uint32_t Tracer::ThreadId()
+{
+    static std::atomic<uint32_t> nextThreadId {1};
+    thread_local uint32_t        threadId = nextThreadId++;
+    return threadId;
+}
+
+Tracer::Tracer() : m_isFirstEvent {true}, m_numDropped {0}, m_isStopping {false} {}
+
+Tracer::~Tracer()
+{
+    Stop();
+}
+
+void Tracer::Start(const std::string& fileName)
+{
+    if(IsEnabled())
+    {
+        throw std::runtime_error("Tracing already started");
+    }
+
+    m_file.open(fileName, std::ios::out | std::ios::trunc);
+    if(!m_file.is_open())
+    {
+        throw std::runtime_error("Unable to open trace file " + fileName);
+    }
+    m_file.setf(std::ios::fixed);
+    m_file.precision(3);
+    m_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    // the whole pool is allocated here so that recording never allocates
+    m_chunk = std::vector<Event>();
+    m_chunk.reserve(s_chunkSize);
+    m_pendingChunks.reserve(s_numChunks);
+    m_freeChunks.reserve(s_numChunks);
+    for(size_t i = 1; i < s_numChunks; i++)
+    {
+        m_freeChunks.emplace_back().reserve(s_chunkSize);
+    }
+
+    m_startTime    = std::chrono::steady_clock::now();
+    m_isFirstEvent = true;
+    m_isStopping   = false;
+    m_numDropped   = 0;
+    m_writer = std::thread(&Tracer::WriteEvents, this);
+    s_isEnabled.store(true);
+}
+
+void Tracer::Stop()
+{
+    if(!IsEnabled())
+    {
+        return;
+    }
+    s_isEnabled.store(false);
+
+    // hand over the partially filled chunk and let the writer drain the queue
+    {
+        std::lock_guard<std::mutex> chunkLock(m_chunkMutex);
+        std::lock_guard<std::mutex> queueLock(m_queueMutex);
+        if(!m_chunk.empty())
+        {
+            m_pendingChunks.push_back(std::move(m_chunk));
+            m_chunk = std::vector<Event>();
+        }
+        m_isStopping = true;
+    }
+    m_queueSignal.notify_one();
+    m_writer.join();
+
+    m_file << "]}" << std::endl;
+    m_file.close();
+    m_freeChunks.clear();
+    if(m_numDropped > 0)
+    {
+        std::cout << "Tracer: " << m_numDropped << " events dropped while the writer was behind" << std::endl;
+    }
+}
+
+// called on the rendering thread, formatting and I/O are left to the writer
+void Tracer::Record(const Event& event)
+{
+    std::lock_guard<std::mutex> chunkLock(m_chunkMutex);
+    if(!IsEnabled())
+    {
+        return;
+    }
+    if(m_chunk.capacity() == 0)
+    {
+        std::lock_guard<std::mutex> queueLock(m_queueMutex);
+        if(m_freeChunks.empty())
+        {
+            m_numDropped++;
+            return;
+        }
+        m_chunk = std::move(m_freeChunks.back());
+        m_freeChunks.pop_back();
+    }
+    m_chunk.push_back(event);
+    if(m_chunk.size() == s_chunkSize)
+    {
+        {
+            std::lock_guard<std::mutex> queueLock(m_queueMutex);
+            m_pendingChunks.push_back(std::move(m_chunk));
+        }
+        m_queueSignal.notify_one();
+        m_chunk = std::vector<Event>();
+    }
+}
+
+void Tracer::WriteEvents()
+{
+    std::unique_lock<std::mutex> queueLock(m_queueMutex);
+    while(true)
+    {
+        m_queueSignal.wait(queueLock, [this]() { return m_isStopping || !m_pendingChunks.empty(); });
+        if(m_pendingChunks.empty())
+        {
+            break;
+        }
+
+        auto chunk = std::move(m_pendingChunks.front());
+        m_pendingChunks.erase(m_pendingChunks.begin());
+        queueLock.unlock();
+
+        for(const auto& event : chunk)
+        {
+            WriteEvent(event);
+        }
+        chunk.clear();
+
+        queueLock.lock();
+        m_freeChunks.push_back(std::move(chunk));
+    }
+}
+
+void Tracer::WriteEvent(const Event& event)
+{
+    const auto startTime = std::chrono::duration<double, std::micro>(event.start - m_startTime).count();
+    const auto duration  = std::chrono::duration<double, std::micro>(event.end - event.start).count();
+
+    m_file << (m_isFirstEvent ? "\n" : ",\n");
+    m_isFirstEvent = false;
+
+    m_file << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << startTime
+           << ",\"dur\":" << duration << ",\"pid\":1,\"tid\":" << event.threadId;
+    if(event.intArgName || event.textArgName)
+    {
+        m_file << ",\"args\":{";
+        if(event.intArgName)
+        {
+            m_file << "\"" << event.intArgName << "\":" << event.intArg << (event.textArgName ? "," : "");
+        }
+        if(event.textArgName)
+        {
+            // lump names are plain ASCII but may contain characters JSON needs escaped
+            m_file << "\"" << event.textArgName << "\":\"";
+            for(const char* c = event.textArg.data(); *c; c++)
+            {
+                if(*c == '"' || *c == '\\')
+                {
+                    m_file << '\\';
+                }
+                if(static_cast<unsigned char>(*c) >= 0x20)
+                {
+                    m_file << *c;
+                }
+            }
+            m_file << "\"";
+        }
+        m_file << "}";
+    }
+    m_file << "}";
+}
+} // namespace rtdoom
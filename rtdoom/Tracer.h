@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace rtdoom
+{
+// singleton writing timed events in Chrome trace-event JSON format (chrome://tracing, Perfetto)
+// events are buffered in a fixed pool of chunks which a background thread formats and writes out,
+// when all of them are waiting for the writer further events are dropped rather than allocating more
+class Tracer
+{
+public:
+    struct Event
+    {
+        const char*                           name;
+        const char*                           category;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+        uint32_t                              threadId;
+        const char*                           intArgName;
+        long long                             intArg;
+        const char*                           textArgName;
+        std::array<char, 16>                  textArg;
+    };
+
+    static Tracer& instance();
+    static bool    IsEnabled()
+    {
+        return s_isEnabled.load(std::memory_order_relaxed);
+    }
+    static uint32_t ThreadId();
+
+    void Start(const std::string& fileName);
+    void Stop();
+    void Record(const Event& event);
+
+    ~Tracer();
+
+protected:
+    Tracer();
+
+    constexpr static size_t  s_chunkSize = 4096;
+    constexpr static size_t  s_numChunks = 8;
+    static std::atomic<bool> s_isEnabled;
+
+    void WriteEvents();
+    void WriteEvent(const Event& event);
+
+    std::ofstream                         m_file;
+    std::chrono::steady_clock::time_point m_startTime;
+    bool                                  m_isFirstEvent;
+
+    // chunk being filled by the renderer, without capacity while waiting for a free one
+    std::mutex         m_chunkMutex;
+    std::vector<Event> m_chunk;
+    size_t             m_numDropped;
+
+    // full chunks waiting for the writer (oldest first) and empty ones ready for reuse, both reserved for the whole pool
+    std::mutex                      m_queueMutex;
+    std::condition_variable         m_queueSignal;
+    std::vector<std::vector<Event>> m_pendingChunks;
+    std::vector<std::vector<Event>> m_freeChunks;
+    bool                            m_isStopping;
+    std::thread                     m_writer;
+};
+
+// records the lifetime of the enclosing block as a single trace event
+class TraceScope
+{
+protected:
+    bool          m_isEnabled;
+    Tracer::Event m_event;
+
+public:
+    TraceScope(const char* name, const char* category) : m_isEnabled {Tracer::IsEnabled()}
+    {
+        if(m_isEnabled)
+        {
+            m_event.name        = name;
+            m_event.category    = category;
+            m_event.intArgName  = nullptr;
+            m_event.textArgName = nullptr;
+            m_event.start       = std::chrono::steady_clock::now();
+        }
+    }
+
+    void Arg(const char* name, long long value)
+    {
+        m_event.intArgName = name;
+        m_event.intArg     = value;
+    }
+
+    void Arg(const char* name, const std::string& value)
+    {
+        m_event.textArgName = name;
+        const auto length   = std::min(value.size(), m_event.textArg.size() - 1);
+        value.copy(m_event.textArg.data(), length);
+        m_event.textArg[length] = 0;
+    }
+
+    bool IsEnabled() const
+    {
+        return m_isEnabled;
+    }
+
+    ~TraceScope()
+    {
+        if(m_isEnabled)
+        {
+            m_event.end      = std::chrono::steady_clock::now();
+            m_event.threadId = Tracer::ThreadId();
+            Tracer::instance().Record(m_event);
+        }
+    }
+};
+} // namespace rtdoom
@@ -1,11 +1,20 @@
 #include "pch.h"
 #include "Viewport.h"
 #include "FrameBuffer32.h"
+#include "FrameBuffer8.h"
+#include "ColumnFrameBuffer32.h"
 
 namespace rtdoom
 {
-Viewport::Viewport(SDL_Renderer* sdlRenderer, Renderer& renderer, int width, int height, const Palette& palette, bool fillTarget) :
-    m_sdlRenderer(sdlRenderer), m_renderer(renderer), m_palette(palette), m_width(width), m_height(height), m_fillTarget(fillTarget)
+Viewport::Viewport(SDL_Renderer*   sdlRenderer,
+                   Renderer&       renderer,
+                   int             width,
+                   int             height,
+                   const Palette&  palette,
+                   const ColorMap* colorMap,
+                   bool            fillTarget) :
+    m_sdlRenderer(sdlRenderer), m_renderer(renderer), m_palette(palette), m_colorMap(colorMap), m_width(width), m_height(height),
+    m_fillTarget(fillTarget), m_frameBufferType(FrameBufferType::Direct)
 {
     Initialize();
 }
@@ -19,7 +28,18 @@ void Viewport::Initialize()
         throw std::runtime_error("Unable to create texture");
     }
 
-    m_frameBuffer.reset(new FrameBuffer32(m_width, m_height, m_palette));
+    switch(m_frameBufferType)
+    {
+    case FrameBufferType::Indexed:
+        m_frameBuffer.reset(new FrameBuffer8(m_width, m_height, m_palette, m_colorMap));
+        break;
+    case FrameBufferType::ColumnMajor:
+        m_frameBuffer.reset(new ColumnFrameBuffer32(m_width, m_height, m_palette, m_colorMap));
+        break;
+    default:
+        m_frameBuffer.reset(new FrameBuffer32(m_width, m_height, m_palette, m_colorMap));
+        break;
+    }
 
     if(!m_fillTarget)
     {
@@ -46,6 +66,18 @@ void Viewport::Resize(int width, int height)
     m_width  = width;
     m_height = height;
     Initialize();
+    m_renderer.Resize(width, height);
+}
+
+// frame buffers other than Direct draw into their own memory and convert it into the texture once per frame
+void Viewport::SetFrameBufferType(FrameBufferType frameBufferType)
+{
+    if(frameBufferType != m_frameBufferType)
+    {
+        Uninitialize();
+        m_frameBufferType = frameBufferType;
+        Initialize();
+    }
 }
 
 void Viewport::Draw()
@@ -61,6 +93,7 @@ void Viewport::Draw()
     m_frameBuffer->Attach(pixelBuffer, []() {});
 
     m_renderer.RenderFrame(*m_frameBuffer);
+    m_frameBuffer->Flush();
 
     SDL_UnlockTexture(m_screenTexture);
 
@@ -83,6 +116,8 @@ void Viewport::DrawSteps()
         {
             return;        
 		}
+        m_frameBuffer->Flush();
+
         void* sdlBuffer;
         int   pitch;
 
@@ -9,16 +9,27 @@ namespace rtdoom
 {
 class Viewport
 {
+public:
+    // where the renderer draws before the frame reaches the texture
+    enum class FrameBufferType
+    {
+        Direct, // FrameBuffer32 writing straight into the texture
+        Indexed, // FrameBuffer8, palette indices expanded in Flush
+        ColumnMajor // ColumnFrameBuffer32, columns transposed in Flush
+    };
+
 protected:
-    int  m_width;
-    int  m_height;
-    bool m_fillTarget;
+    int             m_width;
+    int             m_height;
+    bool            m_fillTarget;
+    FrameBufferType m_frameBufferType;
 
     SDL_Renderer* m_sdlRenderer;
     SDL_Texture*  m_screenTexture;
     Renderer&     m_renderer;
 
     const Palette&               m_palette;
+    const ColorMap*              m_colorMap;
     std::unique_ptr<SDL_Rect>    m_targetRect;
     std::unique_ptr<FrameBuffer> m_frameBuffer;
 
@@ -26,8 +37,19 @@ protected:
     void Uninitialize();
 
 public:
-    Viewport(SDL_Renderer* sdlRenderer, Renderer& renderer, int width, int height, const Palette& palette, bool fillTarget);
+    Viewport(SDL_Renderer*   sdlRenderer,
+             Renderer&       renderer,
+             int             width,
+             int             height,
+             const Palette&  palette,
+             const ColorMap* colorMap,
+             bool            fillTarget);
     void Resize(int width, int height);
+    void SetFrameBufferType(FrameBufferType frameBufferType);
+    FrameBufferType GetFrameBufferType() const
+    {
+        return m_frameBufferType;
+    }
     void Draw();
     void DrawSteps();
     ~Viewport();
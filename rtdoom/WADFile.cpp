@@ -1,6 +1,10 @@
 #include "pch.h"
 #include "WADFile.h"
 #include "Helpers.h"
+#include "Tracer.h"
+#include "SpanDrawer.h"
+
+#include <limits>
 
 namespace rtdoom
 {
@@ -12,17 +16,21 @@ WADFile::WADFile(const std::string& fileName)
         throw std::runtime_error("Unable to open file " + fileName);
     }
 
-    Header header;
-    infile.read(reinterpret_cast<char*>(&header), sizeof(header));
-    infile.clear();
-    infile.seekg(header.dirLocation);
-
     std::vector<Lump> lumps;
-    for(auto i = 0; i < header.numEntries; i++)
     {
-        Lump lump;
-        infile.read(reinterpret_cast<char*>(&lump), sizeof(lump));
-        lumps.push_back(lump);
+        TraceScope trace("directory", "wad");
+        Header     header;
+        infile.read(reinterpret_cast<char*>(&header), sizeof(header));
+        infile.clear();
+        infile.seekg(header.dirLocation);
+
+        for(auto i = 0; i < header.numEntries; i++)
+        {
+            Lump lump;
+            infile.read(reinterpret_cast<char*>(&lump), sizeof(lump));
+            lumps.push_back(lump);
+        }
+        trace.Arg("lumps", header.numEntries);
     }
 
     // find and load maps and patches
@@ -32,6 +40,8 @@ WADFile::WADFile(const std::string& fileName)
         switch(GetLumpType(lump))
         {
         case LumpType::MapMarker: {
+            TraceScope trace("map", "wad");
+            trace.Arg("name", Helpers::MakeString(lump.lumpName));
             std::map<std::string, std::vector<char>> mapLumps;
             for(auto j = 1; j <= 10; j++)
             {
@@ -48,6 +58,14 @@ WADFile::WADFile(const std::string& fileName)
             Helpers::LoadEntity<Palette>(LoadLump(infile, lump), &m_palette);
             break;
         }
+        case LumpType::ColorMap: {
+            if(lump.dataSize >= static_cast<int>(sizeof(ColorMap)))
+            {
+                m_colorMap = std::make_unique<ColorMap>();
+                Helpers::LoadEntity<ColorMap>(LoadLump(infile, lump), m_colorMap.get());
+            }
+            break;
+        }
         case LumpType::PatchNames: {
             auto lumpData = LoadLump(infile, lump);
             int  numPatches;
@@ -61,7 +79,8 @@ WADFile::WADFile(const std::string& fileName)
             break;
         }
         case LumpType::PatchesStart: {
-            int j = 1;
+            TraceScope trace("patches", "wad");
+            int        j = 1;
             while(GetLumpType(lumps.at(i + j)) != LumpType::PatchesEnd)
             {
                 const Lump& patchLump = lumps.at(i + j);
@@ -70,10 +89,12 @@ WADFile::WADFile(const std::string& fileName)
                 m_patches.insert(make_pair(Helpers::MakeString(patchLump.lumpName), p));
                 j++;
             }
+            trace.Arg("lumps", j - 1);
             break;
         }
         case LumpType::SpritesStart: {
-            int j = 1;
+            TraceScope trace("sprites", "wad");
+            int        j = 1;
             while(GetLumpType(lumps.at(i + j)) != LumpType::SpritesEnd)
             {
                 const Lump& patchLump = lumps.at(i + j);
@@ -92,10 +113,12 @@ WADFile::WADFile(const std::string& fileName)
                 }
                 j++;
             }
+            trace.Arg("lumps", j - 1);
             break;
         }
         case LumpType::FlatsStart: {
-            int j = 1;
+            TraceScope trace("flats", "wad");
+            int        j = 1;
             while(GetLumpType(lumps.at(i + j)) != LumpType::FlatsEnd)
             {
                 const Lump& patchLump = lumps.at(i + j);
@@ -106,13 +129,15 @@ WADFile::WADFile(const std::string& fileName)
                 t->height = 64;
                 t->name   = Helpers::MakeString(patchLump.lumpName);
                 t->masked = 0;
-                t->pixels = std::make_unique<unsigned char[]>(t->width * t->height);
+                t->pixels = std::make_unique<unsigned char[]>(t->width * t->height + Texture::s_padding);
 
                 memcpy(t->pixels.get(), patchData.data(), 64 * 64);
+                t->tiles = BuildTiles(t->pixels.get(), t->width, t->height);
 
                 m_textures.insert(make_pair(t->name, t));
                 j++;
             }
+            trace.Arg("lumps", j - 1);
             break;
         }
         default:
@@ -126,9 +151,12 @@ WADFile::WADFile(const std::string& fileName)
         switch(GetLumpType(lump))
         {
         case LumpType::Texture: {
+            TraceScope trace("textures", "wad");
             auto       data = LoadLump(infile, lump);
             signed int numTextures;
             memcpy(&numTextures, data.data(), sizeof(numTextures));
+            trace.Arg("textures", numTextures);
+            trace.Arg("name", Helpers::MakeString(lump.lumpName));
             std::vector<int> textureOffsets;
             for(auto i = 0; i < numTextures; i++)
             {
@@ -150,7 +178,7 @@ WADFile::WADFile(const std::string& fileName)
                 t->height = textureInfo.height;
                 t->name   = Helpers::MakeString(textureInfo.name);
                 t->masked = textureInfo.masked;
-                t->pixels = std::make_unique<unsigned char[]>(t->width * t->height);
+                t->pixels = std::make_unique<unsigned char[]>(t->width * t->height + Texture::s_padding);
                 memset(t->pixels.get(), static_cast<unsigned char>(247), t->width * t->height);
 
                 for(const auto& p : patches)
@@ -166,10 +194,166 @@ WADFile::WADFile(const std::string& fileName)
             }
         }
         break;
+        default:
+            break;
         }
     }
 
-    TryLoadGWA(fileName);
+    // number textures and flats densely so that renderers can index them
+    m_texturesById.reserve(m_textures.size());
+    for(const auto& [name, texture] : m_textures)
+    {
+        texture->id = static_cast<int>(m_texturesById.size());
+        m_texturesById.push_back(texture);
+        BuildColumns(texture->columns, texture->pixels.get(), texture->width, texture->height);
+    }
+    {
+        TraceScope trace("mipmaps", "wad");
+        for(const auto& texture : m_texturesById)
+        {
+            BuildMipLevels(*texture);
+        }
+    }
+    for(const auto& [name, sprite] : m_sprites)
+    {
+        BuildColumns(sprite->columns, sprite->pixels.get(), sprite->width, sprite->height);
+    }
+
+    {
+        TraceScope trace("gwa", "wad");
+        TryLoadGWA(fileName);
+    }
+}
+
+void WADFile::BuildColumns(TexelColumns& columns, const unsigned char* pixels, int width, int height)
+{
+    const auto maskOf = [](int size) { return (size & (size - 1)) == 0 ? size - 1 : TexelColumns::s_noMask; };
+
+    columns.columnBits = 0;
+    while((1 << columns.columnBits) < height)
+    {
+        columns.columnBits++;
+    }
+    columns.widthMask  = maskOf(width);
+    columns.heightMask = maskOf(height);
+
+    // padding below each column is never read, it only aligns the columns
+    const auto columnHeight = 1 << columns.columnBits;
+    columns.texels          = std::make_unique<unsigned char[]>(width * columnHeight);
+    memset(columns.texels.get(), static_cast<unsigned char>(247), width * columnHeight);
+    for(auto x = 0; x < width; x++)
+    {
+        for(auto y = 0; y < height; y++)
+        {
+            columns.texels[x * columnHeight + y] = pixels[y * width + x];
+        }
+    }
+}
+
+std::unique_ptr<unsigned char[]> WADFile::BuildTiles(const unsigned char* pixels, int width, int height)
+{
+    const auto widthBits  = SpanDrawer::SizeBits(width);
+    const auto heightBits = SpanDrawer::SizeBits(height);
+    if(widthBits < TextureSpan::s_tileBits || heightBits < TextureSpan::s_tileBits)
+    {
+        return nullptr;
+    }
+
+    auto tiles = std::make_unique<unsigned char[]>(width * height + Texture::s_padding);
+    for(auto y = 0; y < height; y++)
+    {
+        for(auto x = 0; x < width; x++)
+        {
+            tiles[TextureSpan::TiledOffset(x, y, widthBits)] = pixels[y * width + x];
+        }
+    }
+    return tiles;
+}
+
+// each level averages 2x2 texels of the one above as colors and maps them back to the palette,
+// blocks that are mostly transparent stay transparent so that masked textures keep their holes
+void WADFile::BuildMipLevels(Texture& texture)
+{
+    auto source = texture.pixels.get();
+    auto width  = static_cast<int>(texture.width);
+    auto height = static_cast<int>(texture.height);
+    while(static_cast<int>(texture.mipLevels.size()) < Texture::s_maxMipLevels && width % 2 == 0 && height % 2 == 0 && width > 1 &&
+          height > 1)
+    {
+        width /= 2;
+        height /= 2;
+
+        MipLevel level;
+        level.pixels = std::make_unique<unsigned char[]>(width * height + Texture::s_padding);
+        for(auto y = 0; y < height; y++)
+        {
+            for(auto x = 0; x < width; x++)
+            {
+                const unsigned char block[4] {source[(2 * y) * (2 * width) + 2 * x],
+                                              source[(2 * y) * (2 * width) + 2 * x + 1],
+                                              source[(2 * y + 1) * (2 * width) + 2 * x],
+                                              source[(2 * y + 1) * (2 * width) + 2 * x + 1]};
+
+                auto r = 0, g = 0, b = 0, n = 0;
+                for(const auto colorIndex : block)
+                {
+                    if(colorIndex != 247)
+                    {
+                        const auto& color = m_palette.colors[colorIndex];
+                        r += color.r;
+                        g += color.g;
+                        b += color.b;
+                        n++;
+                    }
+                }
+                level.pixels[y * width + x] = n < 2 ? static_cast<unsigned char>(247) : NearestColor(r / n, g / n, b / n);
+            }
+        }
+        BuildColumns(level.columns, level.pixels.get(), width, height);
+        if(texture.tiles)
+        {
+            level.tiles = BuildTiles(level.pixels.get(), width, height);
+        }
+
+        texture.mipLevels.push_back(std::move(level));
+        source = texture.mipLevels.back().pixels.get();
+    }
+}
+
+// closest palette color to the middle of the 5:5:5 cell, 247 is reserved for transparency
+unsigned char WADFile::NearestColor(int r, int g, int b)
+{
+    if(m_nearestColors.empty())
+    {
+        m_nearestColors.assign(1 << 15, -1);
+    }
+
+    const auto key = ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+    if(m_nearestColors[key] < 0)
+    {
+        const auto cr = (r & ~7) + 4;
+        const auto cg = (g & ~7) + 4;
+        const auto cb = (b & ~7) + 4;
+
+        auto bestDistance = std::numeric_limits<int>::max();
+        for(auto i = 0; i < 256; i++)
+        {
+            const auto& color    = m_palette.colors[i];
+            const auto  distance = (color.r - cr) * (color.r - cr) + (color.g - cg) * (color.g - cg) + (color.b - cb) * (color.b - cb);
+            if(i != 247 && distance < bestDistance)
+            {
+                bestDistance         = distance;
+                m_nearestColors[key] = i;
+            }
+        }
+    }
+    return static_cast<unsigned char>(m_nearestColors[key]);
+}
+
+int WADFile::TextureId(const std::string& name) const
+{
+    const auto it = m_textures.find(name);
+    return it == m_textures.end() ? s_noTexture : it->second->id;
 }
 
 void WADFile::TryLoadGWA(const std::string& fileName)
@@ -218,6 +402,8 @@ void WADFile::TryLoadGWA(const std::string& fileName)
             }
             break;
         }
+        default:
+            break;
         }
     }
 }
@@ -328,6 +514,10 @@ WADFile::LumpType WADFile::GetLumpType(const Lump& lump) const
     {
         return LumpType::Palette;
     }
+    if(strncmp(lump.lumpName, "COLORMAP", 8) == 0)
+    {
+        return LumpType::ColorMap;
+    }
     if(strncmp(lump.lumpName, "TEXTURE", 7) == 0)
     {
         return LumpType::Texture;
@@ -1,9 +1,35 @@
 #pragma once
 
+#include "rtdoom.h"
 #include "MapStore.h"
 
 namespace rtdoom
 {
+// column-major copy of an image for the software renderer, columns start 1 << columnBits texels apart so that
+// their height is padded to a power of two, coordinates of power-of-two sizes wrap with a mask instead of a modulo
+struct TexelColumns
+{
+    static constexpr int s_noMask = -1;
+
+    std::unique_ptr<unsigned char[]> texels;
+    int                              columnBits;
+    int                              widthMask; // width - 1 when it is a power of two, otherwise s_noMask
+    int                              heightMask;
+
+    const unsigned char* Column(int x) const
+    {
+        return texels.get() + (x << columnBits);
+    }
+};
+
+// texture downsampled by a power of two, both row-major for spans and column-major for walls
+struct MipLevel
+{
+    std::unique_ptr<unsigned char[]> pixels;
+    TexelColumns                     columns;
+    std::unique_ptr<unsigned char[]> tiles;
+};
+
 #pragma pack(1)
 struct Palette
 {
@@ -17,18 +43,47 @@ struct Palette
     Color24 colors[256];
 };
 
+// COLORMAP lump: palette indices remapped for 32 light levels from brightest to darkest, then invulnerability and all black
+struct ColorMap
+{
+    static constexpr int s_numLightLevels = 32;
+
+    uint8_t maps[34][256];
+};
+#pragma pack()
+
 struct Texture
 {
+    // halvings are kept while both sizes stay even
+    static constexpr int s_maxMipLevels = 4;
+
+    // spare bytes after the pixels, so that SIMD kernels can gather a whole dword at the last texel
+    static constexpr int s_padding = 3;
+
+    int                              id; // dense index into WADFile::m_texturesById
     std::string                      name;
     int                              masked;
     short                            width;
     short                            height;
-    std::unique_ptr<unsigned char[]> pixels;
+    std::unique_ptr<unsigned char[]> pixels; // row-major, as uploaded by GLContext
+    TexelColumns                     columns;
+    std::unique_ptr<unsigned char[]> tiles; // flats only, laid out by TextureSpan::TiledOffset
+    std::vector<MipLevel>            mipLevels; // mipLevels[n] is (width >> (n + 1)) x (height >> (n + 1))
 };
-#pragma pack()
 
 class WADFile
 {
+public:
+    struct Patch
+    {
+        short                            width;
+        short                            height;
+        short                            left;
+        short                            top;
+        std::unique_ptr<unsigned char[]> pixels;
+        TexelColumns                     columns;
+    };
+
 protected:
 #pragma pack(1)
     struct Header
@@ -45,15 +100,6 @@ protected:
         char lumpName[8];
     };
 
-    struct Patch
-    {
-        short                            width;
-        short                            height;
-        short                            left;
-        short                            top;
-        std::unique_ptr<unsigned char[]> pixels;
-    };
-
     struct PatchInfo
     {
         short originx;
@@ -81,6 +127,7 @@ protected:
         Unknown,
         MapMarker,
         Palette,
+        ColorMap,
         Texture,
         PatchNames,
         PatchesStart,
@@ -104,14 +151,37 @@ protected:
 
     std::shared_ptr<Patch> LoadPatch(const std::vector<char>& patchLump);
 
+    static void BuildColumns(TexelColumns& columns, const unsigned char* pixels, int width, int height);
+
+    // nullptr unless both sizes are powers of two of at least a tile
+    static std::unique_ptr<unsigned char[]> BuildTiles(const unsigned char* pixels, int width, int height);
+
+    void          BuildMipLevels(Texture& texture);
+    unsigned char NearestColor(int r, int g, int b);
+
+    // palette index by 5:5:5 color, -1 until searched
+    std::vector<int> m_nearestColors;
+
 public:
-    Palette m_palette;
+    Palette                   m_palette;
+    std::unique_ptr<ColorMap> m_colorMap; // nullptr when the file has no COLORMAP
 
     static const std::map<int, std::string>         m_thingTypes;
     std::map<std::string, MapStore>                 m_maps;
     std::map<std::string, std::shared_ptr<Texture>> m_textures;
     std::map<std::string, std::shared_ptr<Patch>>   m_sprites;
 
+    // textures and flats indexed by Texture::id, maps resolve their texture names to ids once when they are built
+    std::vector<std::shared_ptr<Texture>> m_texturesById;
+
+    // s_noTexture for "-" and names missing from the file
+    int TextureId(const std::string& name) const;
+
+    const Texture* GetTexture(int textureId) const
+    {
+        return textureId == s_noTexture ? nullptr : m_texturesById[textureId].get();
+    }
+
     WADFile(const std::string& fileName);
     ~WADFile();
 };
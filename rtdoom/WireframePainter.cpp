@@ -20,7 +20,7 @@ void WireframePainter::PaintWall(int x, const Frame::Span& span, const Frame::Pa
     {
         m_frameBuffer.VerticalLine(x, span.e, span.e, s_wallColor, textureContext.lightness);
     }
-    if(textureContext.textureName != "-" && textureContext.isEdge)
+    if(textureContext.textureId != s_noTexture && textureContext.isEdge)
     {
         m_frameBuffer.VerticalLine(x, span.s + 1, span.e - 1, s_wallColor, textureContext.lightness / 2.0f);
     }
@@ -5,24 +5,54 @@
 #include "glad/glad.h"
 
 #include "GameLoop.h"
+#include "Tracer.h"
+#include "Telemetry.h"
+#include "Helpers.h"
 
 #define ENABLE_GL 1
 
+constexpr auto s_demoFileName = "demo.txt";
+
 using namespace rtdoom;
 using namespace std::string_literals;
 using std::cout, std::endl, std::string;
 
-void                       InitSDL(SDL_Renderer*& sdlRenderer, SDL_Window*& sdlWindow);
-void                       DestroySDL(SDL_Renderer* sdlRenderer, SDL_Window* sdlWindow);
-std::optional<std::string> FindWAD();
+void                            InitSDL(SDL_Renderer*& sdlRenderer, SDL_Window*& sdlWindow);
+void                            DestroySDL(SDL_Renderer* sdlRenderer, SDL_Window* sdlWindow);
+InputLatency::Clock::time_point EventTime(const SDL_Event& event);
 
 #include "WADFile.h"
 
-int main(int /*argc*/, char** /*argv*/)
+int main(int argc, char** argv)
 {
     try
     {
-        auto wadFileName = FindWAD();
+        // rtdoom [--trace file.json] [--csv frames.csv] [--summary seconds]
+        // --trace records a Chrome trace of loading and rendering until exit, --csv logs every frame's stats,
+        // --summary sets how often frame time percentiles are printed (1 second by default, 0 disables)
+        string telemetryFileName;
+        double summaryInterval = 1.0;
+        for(int i = 1; i + 1 < argc; i += 2)
+        {
+            if(argv[i] == "--trace"s)
+            {
+                Tracer::instance().Start(argv[i + 1]);
+            }
+            else if(argv[i] == "--csv"s)
+            {
+                telemetryFileName = argv[i + 1];
+            }
+            else if(argv[i] == "--summary"s)
+            {
+                summaryInterval = std::stod(argv[i + 1]);
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option "s + argv[i]);
+            }
+        }
+
+        auto wadFileName = Helpers::FindWAD();
         if(!wadFileName.has_value())
         {
             throw std::runtime_error("No WAD file found! Drop off a .wad from Doom or Freedoom to .exe directory.");
@@ -37,6 +67,9 @@ int main(int /*argc*/, char** /*argv*/)
         GameLoop gameLoop {sdlRenderer, sdlWindow, wadFile};
         gameLoop.Start(mapIter->second);
 
+        Telemetry telemetry {telemetryFileName, summaryInterval};
+        telemetry.Start();
+
         SDL_Event         event;
         const static auto tickFrequency = SDL_GetPerformanceFrequency();
         auto              tickCounter   = SDL_GetPerformanceCounter();
@@ -63,16 +96,16 @@ int main(int /*argc*/, char** /*argv*/)
                     switch(k.keysym.sym)
                     {
                     case SDLK_UP:
-                        gameLoop.Move(p ? 1 : 0);
+                        gameLoop.Move(p ? 1 : 0, EventTime(event));
                         break;
                     case SDLK_DOWN:
-                        gameLoop.Move(p ? -1 : 0);
+                        gameLoop.Move(p ? -1 : 0, EventTime(event));
                         break;
                     case SDLK_LEFT:
-                        gameLoop.Rotate(p ? -1 : 0);
+                        gameLoop.Rotate(p ? -1 : 0, EventTime(event));
                         break;
                     case SDLK_RIGHT:
-                        gameLoop.Rotate(p ? 1 : 0);
+                        gameLoop.Rotate(p ? 1 : 0, EventTime(event));
                         break;
                     case SDLK_1:
                         gameLoop.SetRenderingMode(Renderer::RenderingMode::Wireframe);
@@ -96,16 +129,41 @@ int main(int /*argc*/, char** /*argv*/)
                         std::cout << "OpenGL not enabled, recompile with ENABLE_GL = 1" << std::endl;
                         break;
 #endif
+                    case SDLK_5:
+                        gameLoop.SetRenderingMode(Renderer::RenderingMode::Overdraw);
+                        SDL_SetWindowTitle(sdlWindow, "rtdoom (Overdraw)");
+                        break;
                     case SDLK_s:
                         if(p)
                         {
                             gameLoop.StepFrame();
                         }
                         break;
+                    case SDLK_i:
+                        if(p)
+                        {
+                            const auto frameBufferType = gameLoop.ToggleFrameBuffer(Viewport::FrameBufferType::Indexed);
+                            cout << (frameBufferType == Viewport::FrameBufferType::Indexed ? "8-bit indexed" : "32-bit") << " frame buffer"
+                                 << endl;
+                        }
+                        break;
+                    case SDLK_c:
+                        if(p)
+                        {
+                            const auto frameBufferType = gameLoop.ToggleFrameBuffer(Viewport::FrameBufferType::ColumnMajor);
+                            cout << (frameBufferType == Viewport::FrameBufferType::ColumnMajor ? "column-major 32-bit" : "32-bit")
+                                 << " frame buffer" << endl;
+                        }
+                        break;
                     case SDLK_m:
                         // next map
                         if(p)
                         {
+                            if(gameLoop.isRecording())
+                            {
+                                gameLoop.StopRecording(s_demoFileName);
+                                cout << "Demo saved to " << s_demoFileName << endl;
+                            }
                             mapIter++;
                             if(mapIter == wadFile.m_maps.end())
                             {
@@ -114,6 +172,22 @@ int main(int /*argc*/, char** /*argv*/)
                             gameLoop.Start(mapIter->second);
                         }
                         break;
+                    case SDLK_r:
+                        // record inputs for the timedemo
+                        if(p)
+                        {
+                            if(gameLoop.isRecording())
+                            {
+                                gameLoop.StopRecording(s_demoFileName);
+                                cout << "Demo saved to " << s_demoFileName << endl;
+                            }
+                            else
+                            {
+                                gameLoop.StartRecording(mapIter->first);
+                                cout << "Recording demo on " << mapIter->first << endl;
+                            }
+                        }
+                        break;
                     case SDLK_d:
                         cout << "Player position: (" << gameLoop.Player().x << ", " << gameLoop.Player().y << ", " << gameLoop.Player().a
                              << ")" << endl;
@@ -124,25 +198,27 @@ int main(int /*argc*/, char** /*argv*/)
                 }
             }
 
-            const Frame* frame = gameLoop.RenderFrame();
+            const FrameStats* frameStats = gameLoop.RenderFrame();
 
             const auto nextCounter = SDL_GetPerformanceCounter();
             const auto seconds     = (nextCounter - tickCounter) / static_cast<float>(tickFrequency);
             tickCounter            = nextCounter;
             gameLoop.Tick(seconds);
+            telemetry.Push(seconds * 1000.0, frameStats);
+        }
 
-            if(frame != NULL)
-            {
-                cout << "Frame time: " << seconds * 1000.0 << "ms: " << frame->m_numSegments << " segs, " << frame->m_numFloorPlanes << "+"
-                     << frame->m_numCeilingPlanes << " planes, " << frame->m_sprites.size() << " sprites" << endl;
-            }
-            else
-            {
-                cout << "Frame time: " << seconds * 1000.0 << "ms" << endl;
-            }
+        telemetry.Stop();
+
+        if(gameLoop.isRecording())
+        {
+            gameLoop.StopRecording(s_demoFileName);
+            cout << "Demo saved to " << s_demoFileName << endl;
         }
 
+        cout << "Input latency: " << gameLoop.GetInputLatency() << endl;
+
         DestroySDL(sdlRenderer, sdlWindow);
+        Tracer::instance().Stop();
     }
     catch(std::exception& ex)
     {
@@ -203,19 +279,9 @@ void DestroySDL(SDL_Renderer* sdlRenderer, SDL_Window* sdlWindow)
     SDL_Quit();
 }
 
-bool iequals(const string& a, const string& b)
-{
-    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char a, char b) { return tolower(a) == tolower(b); });
-}
-
-std::optional<std::string> FindWAD()
+// SDL stamps events in milliseconds when they are queued, translate that to the steady clock
+InputLatency::Clock::time_point EventTime(const SDL_Event& event)
 {
-    for(const auto& entry : std::filesystem::directory_iterator("."))
-    {
-        if(entry.is_regular_file() && iequals(entry.path().extension().string(), ".wad"))
-        {
-            return entry.path().generic_string();
-        }
-    }
-    return std::nullopt;
+    const auto age = std::chrono::milliseconds(SDL_GetTicks() - event.common.timestamp);
+    return InputLatency::Clock::now() - age;
 }
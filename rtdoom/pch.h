@@ -12,6 +12,8 @@
 #include <thread>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <chrono>
 #include <cmath>
 #include <algorithm>
 #include <filesystem>
@@ -2,6 +2,9 @@
 
 using Angle = float;
 
+// binary angle measurement, a full turn is 2^32 so that angles wrap around on overflow instead of being normalized
+using BinaryAngle = uint32_t;
+
 namespace rtdoom
 {
 // output display size (scaled framebuffer)
@@ -11,8 +14,25 @@ constexpr float s_multisamplingLevel = 0.5f;
 constexpr float s_minDistance        = 1.0f;
 constexpr float s_minScale           = 0.025f;
 constexpr float s_lightnessFactor    = 1500.0f;
+constexpr int   s_noTexture          = -1; // texture id of "-" and textures missing from the WAD
 
 constexpr Angle PI  = 3.14159265359f;
 constexpr Angle PI2 = PI / 2.0f;
 constexpr Angle PI4 = PI / 4.0f;
+
+constexpr BinaryAngle s_angle45  = 0x20000000;
+constexpr BinaryAngle s_angle90  = 0x40000000;
+constexpr BinaryAngle s_angle180 = 0x80000000;
+
+// whole turns of any angle wrap away
+constexpr BinaryAngle ToBinaryAngle(Angle radians) noexcept
+{
+    return static_cast<BinaryAngle>(static_cast<int64_t>(radians * (4294967296.0f / (2 * PI))));
+}
+
+// -PI..PI
+constexpr Angle ToRadians(BinaryAngle angle) noexcept
+{
+    return static_cast<int32_t>(angle) * (2 * PI / 4294967296.0f);
+}
 } // namespace rtdoom
@@ -0,0 +1,637 @@
+#include "pch.h"
+
+#include <iomanip>
+
+#include "WADFile.h"
+#include "GameState.h"
+#include "SoftwareRenderer.h"
+#include "FrameBuffer32.h"
+#include "FrameBuffer8.h"
+#include "ColumnFrameBuffer32.h"
+#include "Demo.h"
+#include "Tracer.h"
+#include "PerfCounters.h"
+#include "AllocationCounter.h"
+#include "Helpers.h"
+
+using namespace rtdoom;
+using std::cout, std::endl, std::string;
+
+namespace
+{
+// frame buffer the renderer draws into, all but Direct convert their pixels to ARGB rows in Flush
+enum class FrameBufferType
+{
+    Direct,
+    Indexed,
+    ColumnMajor
+};
+
+struct Options
+{
+    string                               wadFileName;
+    string                               mapName;
+    string                               demoFileName;
+    string                               csvFileName;
+    string                               traceFileName;
+    string                               perfFileName;
+    bool                                 perf            = false;
+    bool                                 noAllocation    = false;
+    bool                                 mipmaps         = true;
+    bool                                 tiledFlats      = true;
+    FrameBufferType                      frameBufferType = FrameBufferType::Direct;
+    std::vector<Renderer::RenderingMode> modes {Renderer::RenderingMode::Wireframe,
+                                                Renderer::RenderingMode::Solid,
+                                                Renderer::RenderingMode::Textured};
+    std::vector<std::pair<int, int>>     resolutions {{640, 400}};
+    int                                  loops  = 1;
+    int                                  warmup = 10;
+};
+
+// timings and counters collected over a single mode/resolution run
+struct RunResult
+{
+    std::vector<double>     frameTimes;
+    std::vector<FrameStats> frameStats;
+    double                  totalSeconds = 0;
+
+    template <typename T>
+    double Average(T FrameStats::*counter) const
+    {
+        double sum = 0;
+        for(const auto& stats : frameStats)
+        {
+            sum += static_cast<double>(stats.*counter);
+        }
+        return sum / frameStats.size();
+    }
+
+    double AveragePhaseTime(FrameStats::Phase phase) const
+    {
+        double sum = 0;
+        for(const auto& stats : frameStats)
+        {
+            sum += stats.PhaseTime(phase);
+        }
+        return sum / frameStats.size();
+    }
+
+    PerfCounters::Values TotalCounters() const
+    {
+        PerfCounters::Values total;
+        for(const auto& stats : frameStats)
+        {
+            total += stats.frameCounters;
+        }
+        return total;
+    }
+
+    PerfCounters::Values TotalPhaseCounters(FrameStats::Phase phase) const
+    {
+        PerfCounters::Values total;
+        for(const auto& stats : frameStats)
+        {
+            total += stats.PhaseCounters(phase);
+        }
+        return total;
+    }
+
+    AllocationCounter::Values TotalAllocations() const
+    {
+        AllocationCounter::Values total;
+        for(const auto& stats : frameStats)
+        {
+            total += stats.frameAllocations;
+        }
+        return total;
+    }
+
+    AllocationCounter::Values TotalPhaseAllocations(FrameStats::Phase phase) const
+    {
+        AllocationCounter::Values total;
+        for(const auto& stats : frameStats)
+        {
+            total += stats.PhaseAllocations(phase);
+        }
+        return total;
+    }
+};
+
+void PrintUsage()
+{
+    cout << "Usage: timedemo [options] [file.wad]" << endl
+         << "  --map NAME        map to load (default: first map, or the one recorded in the demo)" << endl
+         << "  --demo FILE       demo recorded in rtdoom with the r key (default: full turn at the start position)" << endl
+         << "  --modes LIST      comma-separated wireframe,solid,textured,overdraw (default: wireframe,solid,textured)" << endl
+         << "  --res LIST        comma-separated WxH resolutions (default: 640x400)" << endl
+         << "  --loops N         number of times to play the demo in each run (default: 1)" << endl
+         << "  --warmup N        frames rendered before measuring (default: 10)" << endl
+         << "  --csv FILE        append results to a CSV file, which must be new or have the same columns" << endl
+         << "  --trace FILE      write a Chrome trace-event JSON of WAD loading and every frame" << endl
+         << "  --perf            report IPC and cache/branch misses per phase from hardware counters (Linux)" << endl
+         << "  --perf-csv FILE   as --perf, also writing counters for every frame and phase to a CSV file" << endl
+         << "  --no-alloc        fail if any frame after the warmup allocates heap memory" << endl
+         << "  --indexed         draw palette indices and expand them to ARGB once per frame (FrameBuffer8)" << endl
+         << "  --columns         draw into column-major pixels and transpose them once per frame (ColumnFrameBuffer32)" << endl
+         << "  --no-mipmaps      sample full-size wall textures and flats at any distance" << endl
+         << "  --row-flats       sample flats stored row by row instead of in 8x8 tiles" << endl;
+}
+
+// appended to the mode name in results
+string FrameBufferSuffix(FrameBufferType frameBufferType)
+{
+    switch(frameBufferType)
+    {
+    case FrameBufferType::Indexed:
+        return "/8";
+    case FrameBufferType::ColumnMajor:
+        return "/col";
+    default:
+        return "";
+    }
+}
+
+Options ParseOptions(int argc, char** argv)
+{
+    Options options;
+    for(int i = 1; i < argc; i++)
+    {
+        const string arg(argv[i]);
+        if(arg.size() < 2 || arg.substr(0, 2) != "--")
+        {
+            options.wadFileName = arg;
+            continue;
+        }
+        if(arg == "--perf")
+        {
+            options.perf = true;
+            continue;
+        }
+        if(arg == "--no-alloc")
+        {
+            if(!AllocationCounter::s_isEnabled)
+            {
+                throw std::runtime_error("--no-alloc needs a build with RTDOOM_COUNT_ALLOCATIONS defined");
+            }
+            options.noAllocation = true;
+            continue;
+        }
+        if(arg == "--indexed")
+        {
+            options.frameBufferType = FrameBufferType::Indexed;
+            continue;
+        }
+        if(arg == "--columns")
+        {
+            options.frameBufferType = FrameBufferType::ColumnMajor;
+            continue;
+        }
+        if(arg == "--no-mipmaps")
+        {
+            options.mipmaps = false;
+            continue;
+        }
+        if(arg == "--row-flats")
+        {
+            options.tiledFlats = false;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        const string value(argv[++i]);
+        if(arg == "--map")
+        {
+            options.mapName = value;
+        }
+        else if(arg == "--demo")
+        {
+            options.demoFileName = value;
+        }
+        else if(arg == "--csv")
+        {
+            options.csvFileName = value;
+        }
+        else if(arg == "--trace")
+        {
+            options.traceFileName = value;
+        }
+        else if(arg == "--perf-csv")
+        {
+            options.perfFileName = value;
+            options.perf         = true;
+        }
+        else if(arg == "--loops")
+        {
+            options.loops = std::max(1, std::stoi(value));
+        }
+        else if(arg == "--warmup")
+        {
+            options.warmup = std::max(0, std::stoi(value));
+        }
+        else if(arg == "--modes")
+        {
+            options.modes.clear();
+            for(const auto& modeName : Helpers::Split(value, ','))
+            {
+                const auto mode = Renderer::ParseMode(modeName);
+                if(!mode.has_value())
+                {
+                    throw std::runtime_error("Unknown rendering mode " + modeName);
+                }
+                options.modes.push_back(*mode);
+            }
+        }
+        else if(arg == "--res")
+        {
+            options.resolutions.clear();
+            for(const auto& resolution : Helpers::Split(value, ','))
+            {
+                const auto separator = resolution.find('x');
+                if(separator == string::npos)
+                {
+                    throw std::runtime_error("Invalid resolution " + resolution);
+                }
+                const auto width  = std::stoi(resolution.substr(0, separator));
+                const auto height = std::stoi(resolution.substr(separator + 1));
+                if(width <= 0 || height <= 0)
+                {
+                    throw std::runtime_error("Invalid resolution " + resolution);
+                }
+                options.resolutions.emplace_back(width, height);
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+double Percentile(std::vector<double> values, double percentile)
+{
+    if(values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const auto rank = static_cast<size_t>(std::ceil(percentile * values.size()));
+    return values[std::clamp(rank, static_cast<size_t>(1), values.size()) - 1];
+}
+
+void PrintCounters(const char* name, const PerfCounters::Values& counters, size_t numFrames)
+{
+    cout << "  " << std::left << std::setw(11) << name << std::right << std::fixed << std::setprecision(0) << std::setw(12)
+         << static_cast<double>(counters[PerfCounters::Counter::Cycles]) / numFrames << std::setprecision(2) << std::setw(7)
+         << counters.IPC() << std::setw(10) << counters.MPKI(PerfCounters::Counter::L1DMisses) << std::setw(10)
+         << counters.MPKI(PerfCounters::Counter::LLCMisses) << std::setw(13) << counters.MPKI(PerfCounters::Counter::BranchMisses)
+         << std::defaultfloat << endl;
+}
+
+void WriteCounters(std::ofstream& perfFile, const string& run, size_t frame, const char* phase, const PerfCounters::Values& counters)
+{
+    perfFile << run << "," << frame << "," << phase;
+    for(const auto count : counters.counts)
+    {
+        perfFile << "," << count;
+    }
+    perfFile << "," << counters.IPC() << "," << counters.MPKI(PerfCounters::Counter::L1DMisses) << ","
+             << counters.MPKI(PerfCounters::Counter::LLCMisses) << "," << counters.MPKI(PerfCounters::Counter::BranchMisses) << endl;
+}
+
+RunResult Run(const Options&          options,
+              const MapStore&         mapStore,
+              const Demo&             demo,
+              const WADFile&          wadFile,
+              Renderer::RenderingMode mode,
+              int                     width,
+              int                     height,
+              const PerfCounters*     perfCounters)
+{
+    GameState        gameState;
+    SoftwareRenderer renderer {gameState, wadFile};
+    std::unique_ptr<FrameBuffer> frameBuffer;
+    switch(options.frameBufferType)
+    {
+    case FrameBufferType::Indexed:
+        frameBuffer.reset(new FrameBuffer8(width, height, wadFile.m_palette, wadFile.m_colorMap.get()));
+        break;
+    case FrameBufferType::ColumnMajor:
+        frameBuffer.reset(new ColumnFrameBuffer32(width, height, wadFile.m_palette, wadFile.m_colorMap.get()));
+        break;
+    default:
+        frameBuffer.reset(new FrameBuffer32(width, height, wadFile.m_palette, wadFile.m_colorMap.get()));
+        break;
+    }
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    frameBuffer->Attach(pixels.data(), []() {});
+    renderer.SetMode(mode);
+    renderer.SetPerfCounters(perfCounters);
+    renderer.SetMipmaps(options.mipmaps);
+    renderer.SetTiledFlats(options.tiledFlats);
+
+    gameState.NewGame(mapStore, wadFile);
+    gameState.ClipPlayer();
+
+    // render a few frames from the start of the demo to populate caches
+    for(int i = 0; i < options.warmup; i++)
+    {
+        Demo::Play(demo.m_steps[i % demo.m_steps.size()], gameState);
+        renderer.RenderFrame(*frameBuffer);
+        frameBuffer->Flush();
+    }
+
+    RunResult result;
+    result.frameTimes.reserve(demo.m_steps.size() * options.loops);
+    result.frameStats.reserve(demo.m_steps.size() * options.loops);
+    for(int loop = 0; loop < options.loops; loop++)
+    {
+        gameState.NewGame(mapStore, wadFile);
+        gameState.ClipPlayer();
+        for(const auto& step : demo.m_steps)
+        {
+            Demo::Play(step, gameState);
+
+            // converting the pixels to ARGB rows is part of the frame time
+            const auto startTime = std::chrono::steady_clock::now();
+            renderer.RenderFrame(*frameBuffer);
+            frameBuffer->Flush();
+            const auto endTime = std::chrono::steady_clock::now();
+
+            const auto seconds = std::chrono::duration<double>(endTime - startTime).count();
+            result.frameTimes.push_back(seconds * 1000.0);
+            result.totalSeconds += seconds;
+            result.frameStats.push_back(renderer.GetFrameStats());
+
+            // steady-state frames are expected not to touch the heap at all
+            const auto& allocations = renderer.GetFrameStats().frameAllocations;
+            if(options.noAllocation && allocations.numAllocations)
+            {
+                std::ostringstream error;
+                error << "Frame " << result.frameStats.size() - 1 << " made " << allocations.numAllocations << " allocations ("
+                      << allocations.numBytes << " bytes):";
+                for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                {
+                    const auto phase = static_cast<FrameStats::Phase>(p);
+                    error << " " << FrameStats::PhaseName(phase) << " " << renderer.GetFrameStats().PhaseAllocations(phase).numAllocations;
+                }
+                throw std::runtime_error(error.str());
+            }
+        }
+    }
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if(argc > 1 && (string(argv[1]) == "--help" || string(argv[1]) == "-h"))
+        {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        }
+
+        auto options = ParseOptions(argc, argv);
+        if(options.wadFileName.empty())
+        {
+            const auto wadFileName = Helpers::FindWAD();
+            if(!wadFileName.has_value())
+            {
+                throw std::runtime_error("No WAD file found! Pass a .wad file or drop one off to the current directory.");
+            }
+            options.wadFileName = wadFileName.value();
+        }
+
+        if(!options.traceFileName.empty())
+        {
+            Tracer::instance().Start(options.traceFileName);
+        }
+
+        WADFile wadFile(options.wadFileName);
+        if(wadFile.m_maps.empty())
+        {
+            throw std::runtime_error("No maps found in " + options.wadFileName);
+        }
+
+        Demo demo;
+        if(!options.demoFileName.empty())
+        {
+            demo.Load(options.demoFileName);
+        }
+
+        auto mapName = options.mapName.empty() ? demo.m_mapName : options.mapName;
+        if(mapName.empty())
+        {
+            mapName = wadFile.m_maps.begin()->first;
+        }
+        const auto mapIter = wadFile.m_maps.find(mapName);
+        if(mapIter == wadFile.m_maps.end())
+        {
+            throw std::runtime_error("Map " + mapName + " not found");
+        }
+
+        if(demo.m_steps.empty())
+        {
+            GameState gameState;
+            gameState.NewGame(mapIter->second, wadFile);
+            gameState.ClipPlayer();
+            demo = Demo::Turnaround(mapName, gameState.m_player, 360);
+        }
+
+        // counters are opened for this thread only, rendering happens on it
+        PerfCounters  perfCounters;
+        std::ofstream perfFile;
+        if(options.perf)
+        {
+            if(!perfCounters.Open())
+            {
+                cout << "Hardware counters unavailable (Linux only, check /proc/sys/kernel/perf_event_paranoid)" << endl;
+            }
+            else
+            {
+                for(size_t c = 0; c < PerfCounters::s_numCounters; c++)
+                {
+                    const auto counter = static_cast<PerfCounters::Counter>(c);
+                    if(!perfCounters.isAvailable(counter))
+                    {
+                        cout << "Counter " << PerfCounters::CounterName(counter) << " not supported, reported as 0" << endl;
+                    }
+                }
+                if(!options.perfFileName.empty())
+                {
+                    perfFile.open(options.perfFileName);
+                    if(!perfFile.good())
+                    {
+                        throw std::runtime_error("Unable to write file " + options.perfFileName);
+                    }
+                    perfFile << "run,frame,phase";
+                    for(size_t c = 0; c < PerfCounters::s_numCounters; c++)
+                    {
+                        perfFile << "," << PerfCounters::CounterName(static_cast<PerfCounters::Counter>(c));
+                    }
+                    perfFile << ",ipc,l1d_mpki,llc_mpki,branch_mpki" << endl;
+                }
+            }
+        }
+
+        cout << "rtdoom timedemo: " << options.wadFileName << " " << mapName << ", " << demo.m_steps.size() * options.loops
+             << " frames per run" << endl;
+        cout << std::left << std::setw(11) << "mode" << std::setw(11) << "resolution" << std::right << std::setw(8) << "frames"
+             << std::setw(9) << "min ms" << std::setw(9) << "avg ms" << std::setw(9) << "p99 ms" << std::setw(9) << "fps"
+             << std::setw(8) << "segs" << std::setw(8) << "floors" << std::setw(8) << "ceils" << std::setw(9) << "sprites" << endl;
+
+        std::ofstream csvFile;
+        if(!options.csvFileName.empty())
+        {
+            std::ostringstream header;
+            header << "wad,map,mode,width,height,frames,min_ms,avg_ms,p99_ms,fps,segments,floor_planes,ceiling_planes,sprites";
+            for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+            {
+                header << "," << FrameStats::PhaseName(static_cast<FrameStats::Phase>(p)) << "_ms";
+            }
+            header << ",visplanes,clips,subsectors,pixels,texels,allocations,allocated_bytes,overdraw";
+
+            // rows are only appended under the same columns, a file written by another version needs a new name
+            string existingHeader;
+            std::ifstream existingFile(options.csvFileName);
+            std::getline(existingFile, existingHeader);
+            existingFile.close();
+            if(!existingHeader.empty() && existingHeader != header.str())
+            {
+                throw std::runtime_error("File " + options.csvFileName + " has different columns, not appending to it");
+            }
+
+            csvFile.open(options.csvFileName, std::ios::app);
+            if(!csvFile.good())
+            {
+                throw std::runtime_error("Unable to write file " + options.csvFileName);
+            }
+            if(existingHeader.empty())
+            {
+                csvFile << header.str() << endl;
+            }
+        }
+
+        for(const auto mode : options.modes)
+        {
+            for(const auto& [width, height] : options.resolutions)
+            {
+                const auto result =
+                    Run(options, mapIter->second, demo, wadFile, mode, width, height, perfCounters.isOpen() ? &perfCounters : nullptr);
+
+                const auto numFrames = static_cast<double>(result.frameTimes.size());
+                const auto minTime   = *std::min_element(result.frameTimes.begin(), result.frameTimes.end());
+                const auto avgTime   = result.totalSeconds * 1000.0 / numFrames;
+                const auto p99Time   = Percentile(result.frameTimes, 0.99);
+                const auto fps       = numFrames / result.totalSeconds;
+                const auto segments  = result.Average(&FrameStats::numSegments);
+                const auto floors    = result.Average(&FrameStats::numFloorPlanes);
+                const auto ceilings  = result.Average(&FrameStats::numCeilingPlanes);
+                const auto sprites   = result.Average(&FrameStats::numSprites);
+
+                const auto resolution = std::to_string(width) + "x" + std::to_string(height);
+                const auto modeName   = Renderer::ModeName(mode) + FrameBufferSuffix(options.frameBufferType) + (options.mipmaps ? "" : "/nomip") +
+                                        (options.tiledFlats ? "" : "/rows");
+                cout << std::left << std::setw(11) << modeName << std::setw(11) << resolution << std::right << std::setw(8)
+                     << result.frameTimes.size() << std::fixed << std::setprecision(3) << std::setw(9) << minTime << std::setw(9)
+                     << avgTime << std::setw(9) << p99Time << std::setprecision(1) << std::setw(9) << fps << std::setw(8) << segments
+                     << std::setw(8) << floors << std::setw(8) << ceilings << std::setw(9) << sprites << std::defaultfloat << endl;
+
+                // average time spent in each phase and the work done
+                cout << "  " << std::fixed << std::setprecision(3);
+                for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                {
+                    const auto phase = static_cast<FrameStats::Phase>(p);
+                    cout << FrameStats::PhaseName(phase) << " " << result.AveragePhaseTime(phase) << "ms, ";
+                }
+                cout << std::setprecision(1) << result.Average(&FrameStats::numVisplanes) << " visplanes, "
+                     << result.Average(&FrameStats::numClips) << " clips, " << result.Average(&FrameStats::numSubSectors)
+                     << " subsectors, " << std::setprecision(0) << result.Average(&FrameStats::numPixels) << " pixels, "
+                     << result.Average(&FrameStats::numTexels) << " texels" << std::defaultfloat << endl;
+                if(mode == Renderer::RenderingMode::Overdraw)
+                {
+                    cout << "  overdraw " << std::fixed << std::setprecision(2) << result.Average(&FrameStats::overdraw) << ", "
+                         << std::setprecision(0) << result.Average(&FrameStats::numOverdrawnPixels) << " pixels overdrawn, up to "
+                         << result.Average(&FrameStats::maxOverdraw) << " times" << std::defaultfloat << endl;
+                }
+
+                // heap allocations per frame, in total and by phase
+                const auto numFrameAllocations = result.TotalAllocations().numAllocations / numFrames;
+                const auto numFrameBytes       = result.TotalAllocations().numBytes / numFrames;
+                if constexpr(AllocationCounter::s_isEnabled)
+                {
+                    cout << "  " << std::fixed << std::setprecision(1) << numFrameAllocations << " allocations (" << std::setprecision(0)
+                         << numFrameBytes << " bytes): " << std::setprecision(1);
+                    for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                    {
+                        const auto phase = static_cast<FrameStats::Phase>(p);
+                        cout << (p ? ", " : "") << FrameStats::PhaseName(phase) << " "
+                             << result.TotalPhaseAllocations(phase).numAllocations / numFrames;
+                    }
+                    cout << std::defaultfloat << endl;
+                }
+
+                if(csvFile.is_open())
+                {
+                    csvFile << options.wadFileName << "," << mapName << "," << modeName << "," << width << "," << height << ","
+                            << result.frameTimes.size() << "," << minTime << "," << avgTime << "," << p99Time << "," << fps << ","
+                            << segments << "," << floors << "," << ceilings << "," << sprites;
+                    for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                    {
+                        csvFile << "," << result.AveragePhaseTime(static_cast<FrameStats::Phase>(p));
+                    }
+                    csvFile << "," << result.Average(&FrameStats::numVisplanes) << "," << result.Average(&FrameStats::numClips) << ","
+                            << result.Average(&FrameStats::numSubSectors) << "," << result.Average(&FrameStats::numPixels) << ","
+                            << result.Average(&FrameStats::numTexels) << "," << numFrameAllocations << "," << numFrameBytes << ","
+                            << result.Average(&FrameStats::overdraw) << endl;
+                }
+
+                if(perfCounters.isOpen())
+                {
+                    // misses are per thousand instructions
+                    cout << "  " << std::left << std::setw(11) << "counters" << std::right << std::setw(12) << "cycles/frame"
+                         << std::setw(7) << "IPC" << std::setw(10) << "L1D MPKI" << std::setw(10) << "LLC MPKI" << std::setw(13)
+                         << "branch MPKI" << endl;
+                    PrintCounters("frame", result.TotalCounters(), result.frameStats.size());
+                    for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                    {
+                        const auto phase = static_cast<FrameStats::Phase>(p);
+                        PrintCounters(FrameStats::PhaseName(phase), result.TotalPhaseCounters(phase), result.frameStats.size());
+                    }
+                }
+
+                if(perfFile.is_open())
+                {
+                    const auto run = modeName + " " + resolution;
+                    for(size_t f = 0; f < result.frameStats.size(); f++)
+                    {
+                        const auto& stats = result.frameStats[f];
+                        WriteCounters(perfFile, run, f, "frame", stats.frameCounters);
+                        for(size_t p = 0; p < FrameStats::s_numPhases; p++)
+                        {
+                            const auto phase = static_cast<FrameStats::Phase>(p);
+                            WriteCounters(perfFile, run, f, FrameStats::PhaseName(phase), stats.PhaseCounters(phase));
+                        }
+                    }
+                }
+            }
+        }
+
+        if(!options.traceFileName.empty())
+        {
+            Tracer::instance().Stop();
+            cout << "Trace saved to " << options.traceFileName << endl;
+        }
+    }
+    catch(std::exception& ex)
+    {
+        cout << "Exception: " << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}